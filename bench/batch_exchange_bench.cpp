@@ -0,0 +1,76 @@
+#include "batch_exchange_queue.hpp"
+#include "bench_common.hpp"
+#include "blocking_pmr_queue.hpp"
+#include "pmr_queue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::uint64_t kMessages = 2'000'000;
+
+void print_rate(const std::string& label, double elapsed_ns) {
+    std::cout << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << static_cast<double>(kMessages) * 1e3 / elapsed_ns << " M msg/s\n";
+}
+
+// Reference: one lock acquisition per element on each side.
+void run_per_element() {
+    BlockingPmrQueue<std::uint64_t> queue(4096, std::pmr::new_delete_resource());
+    Stopwatch watch;
+    std::thread producer([&queue] {
+        for (std::uint64_t value = 0; value < kMessages; ++value) {
+            queue.push(value);
+        }
+        queue.close();
+    });
+    std::uint64_t sum = 0;
+    std::uint64_t value = 0;
+    while (queue.pop(value)) {
+        sum += value;
+    }
+    producer.join();
+    do_not_optimize(sum);
+    print_rate("BlockingPmrQueue per element", watch.elapsed_ns());
+}
+
+void run_batched(std::size_t batch_size) {
+    BatchExchangeQueue<std::uint64_t> exchange(std::pmr::new_delete_resource(), batch_size);
+    Stopwatch watch;
+    std::thread producer([&exchange] {
+        for (std::uint64_t value = 0; value < kMessages; ++value) {
+            exchange.push(value);
+        }
+        exchange.close();
+    });
+    PmrQueue<std::uint64_t> batch(std::pmr::new_delete_resource());
+    std::uint64_t sum = 0;
+    while (!exchange.closed()) {
+        exchange.take_for(batch, std::chrono::milliseconds(10));
+        while (!batch.empty()) {
+            sum += batch.front();
+            batch.pop();
+        }
+    }
+    producer.join();
+    do_not_optimize(sum);
+    print_rate("BatchExchangeQueue batch " + std::to_string(batch_size), watch.elapsed_ns());
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "SPSC handoff of " << kMessages << " messages\n";
+    run_per_element();
+    for (const std::size_t batch_size : {16, 64, 256, 1024}) {
+        run_batched(batch_size);
+    }
+    return 0;
+}
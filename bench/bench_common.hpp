@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <algorithm>
+#include <iostream>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// Forwards to an upstream resource and counts every call that reaches it.
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {}
+
+    std::size_t allocations() const noexcept { return allocations_; }
+    std::size_t deallocations() const noexcept { return deallocations_; }
+    std::size_t calls() const noexcept { return allocations_ + deallocations_; }
+
+    void reset_counters() noexcept {
+        allocations_ = 0;
+        deallocations_ = 0;
+    }
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::size_t allocations_{0};
+    std::size_t deallocations_{0};
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations_;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+        ++deallocations_;
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+class Stopwatch {
+public:
+    using clock = std::chrono::steady_clock;
+
+    Stopwatch() : start_(clock::now()) {}
+
+    void restart() { start_ = clock::now(); }
+
+    double elapsed_ns() const {
+        return std::chrono::duration<double, std::nano>(clock::now() - start_).count();
+    }
+
+private:
+    clock::time_point start_;
+};
+
+// Share of free bytes that lie outside the largest free gap: 0 means one contiguous hole.
+template <class Resource>
+double fragmentation_of(const Resource& resource) {
+    const std::size_t free_bytes = resource.capacity() - resource.used_bytes();
+    return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(resource.largest_free_gap()) / free_bytes;
+}
+
+struct LatencyPercentiles {
+    double p50{0};
+    double p99{0};
+    double p9999{0};
+    double max{0};
+};
+
+// Nearest-rank percentiles of per-operation latencies; sorts the samples in place.
+inline LatencyPercentiles latency_percentiles(std::vector<double>& samples) {
+    if (samples.empty()) {
+        return {};
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto rank = [&](double fraction) {
+        return samples[static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1))];
+    };
+    return {rank(0.50), rank(0.99), rank(0.9999), samples.back()};
+}
+
+// Keeps the optimizer from discarding benchmark results.
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void print_row(std::string_view name, double ns_per_op, double calls_per_op) {
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << ns_per_op << " ns/op" << std::setw(12) << calls_per_op
+              << " resource calls/op\n";
+}
@@ -0,0 +1,101 @@
+#include "bench_common.hpp"
+#include "buddy_memory_resource.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kCapacity = 1 << 20;
+constexpr std::size_t kOperations = 200000;
+constexpr std::size_t kLiveTarget = 2000;
+
+struct Allocation {
+    void* ptr;
+    std::size_t size;
+};
+
+// Mostly power-of-two request sizes with a little jitter, freed in random order.
+template <class Resource>
+void run_mixed(std::string_view name) {
+    Resource resource(kCapacity);
+    std::mt19937 rng(11);
+    constexpr std::array<std::size_t, 6> sizes{32, 64, 128, 256, 512, 1024};
+    std::uniform_int_distribution<std::size_t> size_pick(0, sizes.size() - 1);
+    std::uniform_int_distribution<std::size_t> jitter(0, 8);
+    std::vector<Allocation> live;
+    std::size_t failures = 0;
+    double fragmentation_sum = 0;
+    std::size_t samples = 0;
+
+    Stopwatch watch;
+    for (std::size_t op = 0; op < kOperations; ++op) {
+        if (live.size() >= kLiveTarget) {
+            std::uniform_int_distribution<std::size_t> pick(0, live.size() - 1);
+            const std::size_t victim = pick(rng);
+            resource.deallocate(live[victim].ptr, live[victim].size);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        const std::size_t size = sizes[size_pick(rng)] - jitter(rng);
+        try {
+            live.push_back({resource.allocate(size), size});
+        } catch (const std::bad_alloc&) {
+            ++failures;
+        }
+        if (op % 1024 == 0) {
+            fragmentation_sum += fragmentation_of(resource);
+            ++samples;
+        }
+    }
+    const double ns_per_op = watch.elapsed_ns() / kOperations;
+    for (const Allocation& allocation : live) {
+        resource.deallocate(allocation.ptr, allocation.size);
+    }
+
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << ns_per_op << " ns/op" << std::setprecision(3) << std::setw(10)
+              << fragmentation_sum / samples << " frag" << std::setw(8) << failures << " failures\n";
+}
+
+template <class Resource>
+void run_queue(std::string_view name) {
+    Resource resource(kCapacity);
+    PmrQueue<std::uint64_t> queue(&resource);
+    constexpr std::size_t depth = 1000;
+    constexpr std::size_t rounds = 200;
+
+    Stopwatch watch;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < depth; ++i) {
+            queue.push(i);
+        }
+        while (!queue.empty()) {
+            queue.pop();
+        }
+    }
+    print_row(name, watch.elapsed_ns() / (depth * rounds), 2.0);
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Mixed power-of-two workload, " << kOperations << " allocations, ~" << kLiveTarget
+              << " live blocks\n";
+    run_mixed<CustomBlockMemoryResource>("first-fit");
+    run_mixed<BuddyMemoryResource>("buddy");
+
+    std::cout << "\nPmrQueue<uint64_t> fill/drain of 1000 elements\n";
+    run_queue<CustomBlockMemoryResource>("first-fit push+pop");
+    run_queue<BuddyMemoryResource>("buddy push+pop");
+    return 0;
+}
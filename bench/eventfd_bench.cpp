@@ -0,0 +1,134 @@
+#include "bench_common.hpp"
+#include "blocking_pmr_queue.hpp"
+#include "notifying_pmr_queue.hpp"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kSamples = 2000;
+constexpr std::int64_t kStop = -1;
+constexpr auto kPause = std::chrono::microseconds(200);
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void print_latency(const char* label, std::vector<double>& samples) {
+    const LatencyPercentiles result = latency_percentiles(samples);
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(0)
+              << " p50 " << result.p50 << " ns, p99 " << result.p99 << " ns, max " << result.max << " ns\n";
+}
+
+// Example consumer: one epoll loop that serves a periodic timer next to the queue, the way a
+// network thread would serve its sockets. Each message carries its send time; the loop
+// records how long it took to see it and returns on kStop.
+std::size_t run_event_loop(NotifyingPmrQueue<std::int64_t>& queue, std::vector<double>& latencies) {
+    const int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    const int timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    const itimerspec period{{0, 10'000'000}, {0, 10'000'000}};
+    ::timerfd_settime(timer_fd, 0, &period, nullptr);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = queue.fd();
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, queue.fd(), &event);
+    event.data.fd = timer_fd;
+    ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+
+    std::size_t ticks = 0;
+    bool running = true;
+    while (running) {
+        epoll_event ready[2];
+        const int count = ::epoll_wait(epoll_fd, ready, 2, -1);
+        for (int i = 0; i < count; ++i) {
+            if (ready[i].data.fd == timer_fd) {
+                std::uint64_t expirations = 0;
+                ticks += ::read(timer_fd, &expirations, sizeof(expirations)) > 0 ? expirations : 0;
+                continue;
+            }
+            queue.drain([&](std::int64_t sent) {
+                if (sent == kStop) {
+                    running = false;
+                } else {
+                    latencies.push_back(static_cast<double>(now_ns() - sent));
+                }
+            });
+        }
+    }
+    ::close(timer_fd);
+    ::close(epoll_fd);
+    return ticks;
+}
+
+void run_eventfd() {
+    NotifyingPmrQueue<std::int64_t> queue;
+    std::vector<double> latencies;
+    latencies.reserve(kSamples);
+    std::size_t ticks = 0;
+    std::thread consumer([&] { ticks = run_event_loop(queue, latencies); });
+    for (std::size_t i = 0; i < kSamples; ++i) {
+        std::this_thread::sleep_for(kPause);
+        queue.push(now_ns());
+    }
+    queue.push(kStop);
+    consumer.join();
+    print_latency("eventfd + epoll_wait", latencies);
+    std::cout << "  timer ticks served alongside: " << ticks << "\n";
+}
+
+// Reference: a consumer thread parked in BlockingPmrQueue::pop on a condition variable.
+void run_condition_variable() {
+    BlockingPmrQueue<std::int64_t> queue(1024);
+    std::vector<double> latencies;
+    latencies.reserve(kSamples);
+    std::thread consumer([&] {
+        std::int64_t sent = 0;
+        while (queue.pop(sent) && sent != kStop) {
+            latencies.push_back(static_cast<double>(now_ns() - sent));
+        }
+    });
+    for (std::size_t i = 0; i < kSamples; ++i) {
+        std::this_thread::sleep_for(kPause);
+        queue.push(now_ns());
+    }
+    queue.push(kStop);
+    consumer.join();
+    print_latency("condition variable", latencies);
+}
+
+// A burst into an idle queue writes the eventfd once.
+void run_burst() {
+    constexpr std::size_t kBurst = 100000;
+    NotifyingPmrQueue<std::int64_t> queue;
+    Stopwatch watch;
+    for (std::size_t i = 0; i < kBurst; ++i) {
+        queue.push(static_cast<std::int64_t>(i));
+    }
+    const double push_ns = watch.elapsed_ns() / kBurst;
+    const std::size_t drained = queue.drain([](std::int64_t value) { do_not_optimize(value); });
+    std::cout << "burst of " << drained << " pushes: " << std::fixed << std::setprecision(1) << push_ns
+              << " ns/push, " << queue.notifications() << " eventfd write(s)\n";
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Wakeup latency of an idle consumer, " << kSamples << " messages\n";
+    run_eventfd();
+    run_condition_variable();
+    run_burst();
+    return 0;
+}
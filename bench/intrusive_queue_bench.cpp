@@ -0,0 +1,78 @@
+#include "bench_common.hpp"
+#include "intrusive_queue.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct Message {
+    std::uint64_t id;
+    std::array<std::uint64_t, 7> payload;
+    IntrusiveQueueHook<Message> queue_hook;
+};
+
+constexpr std::size_t kRounds = 200000;
+constexpr std::size_t kBatch = 32;
+
+void bench_pmr_queue(std::vector<Message>& pool) {
+    CustomBlockMemoryResource buffer(1 << 16);
+    CountingMemoryResource counting(&buffer);
+    PmrQueue<Message> queue(&counting);
+
+    Stopwatch watch;
+    std::uint64_t checksum = 0;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            queue.push(pool[i]);
+        }
+        while (!queue.empty()) {
+            checksum += queue.front().id;
+            queue.pop();
+        }
+    }
+    const double ops = static_cast<double>(kRounds * kBatch);
+    do_not_optimize(checksum);
+    print_row("PmrQueue<Message> push+pop", watch.elapsed_ns() / ops, counting.calls() / ops);
+}
+
+void bench_intrusive_queue(std::vector<Message>& pool) {
+    CustomBlockMemoryResource buffer(1 << 16);
+    CountingMemoryResource counting(&buffer);
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&counting);
+    IntrusiveQueue<Message> queue;
+
+    Stopwatch watch;
+    std::uint64_t checksum = 0;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            queue.push(pool[i]);
+        }
+        while (!queue.empty()) {
+            checksum += queue.front().id;
+            queue.pop();
+        }
+    }
+    const double ops = static_cast<double>(kRounds * kBatch);
+    do_not_optimize(checksum);
+    std::pmr::set_default_resource(previous);
+    print_row("IntrusiveQueue<Message> push+pop", watch.elapsed_ns() / ops, counting.calls() / ops);
+}
+
+}  // namespace
+
+int main() {
+    std::vector<Message> pool(kBatch);
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        pool[i].id = i;
+    }
+
+    std::cout << "Queue of " << kBatch << " pooled messages, " << kRounds << " fill/drain rounds\n";
+    bench_pmr_queue(pool);
+    bench_intrusive_queue(pool);
+    return 0;
+}
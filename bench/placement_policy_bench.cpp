@@ -0,0 +1,129 @@
+#include "bench_common.hpp"
+#include "memory_resource.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kCapacity = 1 << 18;
+constexpr std::size_t kOperations = 200000;
+constexpr std::size_t kLiveTarget = 600;
+
+struct Allocation {
+    void* ptr;
+    std::size_t size;
+};
+
+struct Result {
+    double ns_per_op{0};
+    double fragmentation{0};
+    std::size_t failures{0};
+};
+
+// Streaming: oldest allocation is freed first, like a queue of variable-sized records.
+template <class Resource>
+Result run_streaming() {
+    Resource resource(kCapacity);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> size_dist(16, 512);
+    std::deque<Allocation> live;
+    Result result;
+    double fragmentation_sum = 0;
+    std::size_t samples = 0;
+
+    Stopwatch watch;
+    for (std::size_t op = 0; op < kOperations; ++op) {
+        if (live.size() >= kLiveTarget) {
+            resource.deallocate(live.front().ptr, live.front().size);
+            live.pop_front();
+        }
+        const std::size_t size = size_dist(rng);
+        try {
+            live.push_back({resource.allocate(size), size});
+        } catch (const std::bad_alloc&) {
+            ++result.failures;
+        }
+        if (op % 1024 == 0) {
+            fragmentation_sum += fragmentation_of(resource);
+            ++samples;
+        }
+    }
+    result.ns_per_op = watch.elapsed_ns() / kOperations;
+    result.fragmentation = fragmentation_sum / samples;
+    for (const Allocation& allocation : live) {
+        resource.deallocate(allocation.ptr, allocation.size);
+    }
+    return result;
+}
+
+// Random: a random live allocation is freed, which punches holes everywhere.
+template <class Resource>
+Result run_random() {
+    Resource resource(kCapacity);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::size_t> size_dist(16, 512);
+    std::vector<Allocation> live;
+    Result result;
+    double fragmentation_sum = 0;
+    std::size_t samples = 0;
+
+    Stopwatch watch;
+    for (std::size_t op = 0; op < kOperations; ++op) {
+        if (live.size() >= kLiveTarget) {
+            std::uniform_int_distribution<std::size_t> pick(0, live.size() - 1);
+            const std::size_t victim = pick(rng);
+            resource.deallocate(live[victim].ptr, live[victim].size);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        const std::size_t size = size_dist(rng);
+        try {
+            live.push_back({resource.allocate(size), size});
+        } catch (const std::bad_alloc&) {
+            ++result.failures;
+        }
+        if (op % 1024 == 0) {
+            fragmentation_sum += fragmentation_of(resource);
+            ++samples;
+        }
+    }
+    result.ns_per_op = watch.elapsed_ns() / kOperations;
+    result.fragmentation = fragmentation_sum / samples;
+    for (const Allocation& allocation : live) {
+        resource.deallocate(allocation.ptr, allocation.size);
+    }
+    return result;
+}
+
+void print_result(std::string_view policy, const Result& result) {
+    std::cout << std::left << std::setw(12) << policy << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << result.ns_per_op << " ns/op" << std::setprecision(3) << std::setw(10)
+              << result.fragmentation << " frag" << std::setw(8) << result.failures << " failures\n";
+}
+
+template <class Resource>
+void run_policy(std::string_view policy) {
+    std::cout << "  streaming  ";
+    print_result(policy, run_streaming<Resource>());
+    std::cout << "  random     ";
+    print_result(policy, run_random<Resource>());
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Placement policies over a " << kCapacity << "-byte buffer, " << kOperations
+              << " allocations, ~" << kLiveTarget << " live blocks\n";
+    run_policy<CustomBlockMemoryResource>("first-fit");
+    run_policy<NextFitBlockMemoryResource>("next-fit");
+    run_policy<BestFitBlockMemoryResource>("best-fit");
+    run_policy<WorstFitBlockMemoryResource>("worst-fit");
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "bench_common.hpp"
+#include "memory_resource.hpp"
+#include "node_reclaimer.hpp"
+#include "pmr_queue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kMessages = 50000;
+constexpr std::size_t kFields = 32;
+
+// Message whose destructor releases a nested pmr container of heap-sized strings.
+struct Message {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    explicit Message(std::size_t id, const allocator_type& alloc = {}) : fields(alloc) {
+        fields.reserve(kFields);
+        for (std::size_t i = 0; i < kFields; ++i) {
+            fields.emplace_back("field value long enough to leave the small buffer ");
+        }
+        fields.back() += std::to_string(id);
+    }
+
+    Message(Message&& other, const allocator_type& alloc) : fields(std::move(other.fields), alloc) {}
+
+    std::pmr::vector<std::pmr::string> fields;
+};
+
+// Pops are timed individually while the queue is kept at a steady depth.
+void run(const char* label, ReclaimMode mode, bool deferred) {
+    SynchronizedMemoryResource resource(std::pmr::new_delete_resource());
+    NodeReclaimer reclaimer(mode);
+    PmrQueue<Message> queue(&resource);
+    if (deferred) {
+        queue.set_reclaimer(&reclaimer, 64);
+    }
+    for (std::size_t i = 0; i < 256; ++i) {
+        queue.emplace(i);
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(kMessages);
+    Stopwatch total;
+    for (std::size_t i = 0; i < kMessages; ++i) {
+        queue.emplace(i);
+        do_not_optimize(queue.front().fields.size());
+        Stopwatch watch;
+        queue.pop();
+        latencies.push_back(watch.elapsed_ns());
+        if (deferred && mode == ReclaimMode::quiescent && i % 1024 == 1023) {
+            // Stands in for the idle point of an event loop.
+            queue.flush_retired();
+            reclaimer.quiesce();
+        }
+    }
+    const double total_ns = total.elapsed_ns();
+
+    const LatencyPercentiles result = latency_percentiles(latencies);
+    std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(0)
+              << " pop p50 " << std::setw(6) << result.p50 << " ns, p99 " << std::setw(7) << result.p99
+              << " ns, max " << std::setw(9) << result.max << " ns; " << std::setprecision(1)
+              << total_ns / kMessages << " ns per push+pop\n";
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Consumer pop latency, " << kMessages << " messages with " << kFields << " nested strings each\n";
+    run("inline destruction", ReclaimMode::quiescent, false);
+    run("deferred, quiescent points", ReclaimMode::quiescent, true);
+    run("deferred, background thread", ReclaimMode::background, true);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "bench_common.hpp"
+#include "shared_memory_queue.hpp"
+#include "shared_memory_resource.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kStreamRecords = 200000;
+constexpr std::size_t kRoundTrips = 20000;
+constexpr std::size_t kQueueDepth = 1024;
+
+struct Record {
+    std::uint64_t sequence;
+    std::int64_t sent_ns;
+};
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void print_latency(const char* label, std::vector<double>& samples) {
+    const LatencyPercentiles result = latency_percentiles(samples);
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(0)
+              << " p50 " << result.p50 << " ns, p99 " << result.p99 << " ns, p99.99 " << result.p9999
+              << " ns, max " << result.max << " ns\n";
+}
+
+std::string segment_name(const char* role) {
+    return std::string("/pmr_queue_bench_") + role + "_" + std::to_string(::getpid());
+}
+
+// Producer streams records as fast as the queue accepts them; the consumer process drains
+// in batches and measures enqueue-to-dequeue latency with the shared monotonic clock.
+void run_stream() {
+    const std::size_t bytes = SharedMemoryQueue<Record>::region_bytes_for(kQueueDepth);
+    SharedMemorySegment segment(segment_name("stream"), SharedSegmentMode::create, bytes);
+    SharedMemoryQueue<Record> queue(segment.data(), bytes, SharedSegmentMode::create);
+    std::cout.flush();
+
+    const pid_t consumer = ::fork();
+    if (consumer == 0) {
+        SharedMemorySegment view(segment.name(), SharedSegmentMode::attach);
+        SharedMemoryQueue<Record> peer(view.data(), view.size(), SharedSegmentMode::attach);
+        std::vector<double> latencies;
+        latencies.reserve(kStreamRecords);
+        Stopwatch watch;
+        while (latencies.size() < kStreamRecords) {
+            if (peer.drain([&](const Record& record) {
+                    latencies.push_back(static_cast<double>(now_ns() - record.sent_ns));
+                }) == 0) {
+                std::this_thread::yield();
+            }
+        }
+        const double seconds = watch.elapsed_ns() * 1e-9;
+        std::cout << "Stream of " << kStreamRecords << " records: " << std::fixed << std::setprecision(2)
+                  << kStreamRecords / seconds / 1e6 << " M records/s\n";
+        print_latency("  enqueue-to-dequeue", latencies);
+        std::cout.flush();
+        ::_exit(0);
+    }
+
+    for (std::uint64_t sequence = 0; sequence < kStreamRecords; ++sequence) {
+        while (!queue.try_push({sequence, now_ns()})) {
+            std::this_thread::yield();
+        }
+    }
+    ::waitpid(consumer, nullptr, 0);
+}
+
+// Round trip through two queues: the parent sends a ping and spins until the echo arrives.
+void run_ping_pong() {
+    const std::size_t bytes = SharedMemoryQueue<Record>::region_bytes_for(16);
+    SharedMemorySegment ping_segment(segment_name("ping"), SharedSegmentMode::create, bytes);
+    SharedMemorySegment pong_segment(segment_name("pong"), SharedSegmentMode::create, bytes);
+    SharedMemoryQueue<Record> ping(ping_segment.data(), bytes, SharedSegmentMode::create);
+    SharedMemoryQueue<Record> pong(pong_segment.data(), bytes, SharedSegmentMode::create);
+    std::cout.flush();
+
+    const pid_t echo = ::fork();
+    if (echo == 0) {
+        SharedMemorySegment ping_view(ping_segment.name(), SharedSegmentMode::attach);
+        SharedMemorySegment pong_view(pong_segment.name(), SharedSegmentMode::attach);
+        SharedMemoryQueue<Record> requests(ping_view.data(), ping_view.size(), SharedSegmentMode::attach);
+        SharedMemoryQueue<Record> replies(pong_view.data(), pong_view.size(), SharedSegmentMode::attach);
+        Record record{};
+        for (std::size_t round = 0; round < kRoundTrips; ++round) {
+            while (!requests.try_pop(record)) {
+                std::this_thread::yield();
+            }
+            replies.push(record);
+        }
+        ::_exit(0);
+    }
+
+    std::vector<double> round_trips;
+    round_trips.reserve(kRoundTrips);
+    Record reply{};
+    for (std::uint64_t round = 0; round < kRoundTrips; ++round) {
+        const std::int64_t sent = now_ns();
+        ping.push({round, sent});
+        while (!pong.try_pop(reply)) {
+            std::this_thread::yield();
+        }
+        round_trips.push_back(static_cast<double>(now_ns() - sent));
+    }
+    ::waitpid(echo, nullptr, 0);
+    std::cout << "Ping-pong, " << kRoundTrips << " round trips\n";
+    print_latency("  round trip", round_trips);
+}
+
+}  // namespace
+
+int main() {
+    run_stream();
+    run_ping_pong();
+    return 0;
+}
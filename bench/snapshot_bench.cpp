@@ -0,0 +1,100 @@
+#include "bench_common.hpp"
+#include "compact_pmr_queue.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+#include "queue_snapshot.hpp"
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kElements = std::size_t{1} << 20;
+// CompactPmrQueue allocates node by node, and the block table makes that quadratic.
+constexpr std::size_t kCompactElements = std::size_t{1} << 14;
+
+struct Record {
+    std::uint64_t id;
+    std::uint64_t payload[3];
+};
+
+void print_time(const char* label, double elapsed_ns, std::uintmax_t bytes) {
+    std::cout << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << elapsed_ns * 1e-6 << " ms" << std::setw(10)
+              << static_cast<double>(bytes) / elapsed_ns << " GB/s\n";
+}
+
+// Baseline: the elements are stored as a flat array and pushed back one by one on restart.
+void run_rebuild(const std::filesystem::path& path) {
+    {
+        std::vector<Record> records(kElements);
+        for (std::size_t i = 0; i < kElements; ++i) {
+            records[i].id = i;
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(Record)));
+    }
+    CustomBlockMemoryResource resource(kElements * PmrQueue<Record>::node_size() + 4096);
+    PmrQueue<Record> queue(&resource);
+    queue.reserve(kElements);
+    Stopwatch watch;
+    std::vector<Record> records(kElements);
+    std::ifstream in(path, std::ios::binary);
+    in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+    for (const Record& record : records) {
+        queue.push(record);
+    }
+    print_time("rebuild element by element", watch.elapsed_ns(), std::filesystem::file_size(path));
+    do_not_optimize(queue.front());
+}
+
+template <class Queue, class MakeQueue>
+void run_snapshot(const char* label, const std::filesystem::path& path, std::size_t elements, std::size_t node_size,
+                  MakeQueue make_queue) {
+    const std::size_t capacity = elements * node_size + 4096;
+    {
+        CustomBlockMemoryResource resource(capacity);
+        Queue queue = make_queue(resource);
+        if constexpr (requires { queue.reserve(elements); }) {
+            queue.reserve(elements);
+        }
+        for (std::size_t i = 0; i < elements; ++i) {
+            queue.push(Record{i, {}});
+        }
+        snapshot_queue(path, resource, queue);
+    }
+    CustomBlockMemoryResource resource(capacity);
+    Queue queue = make_queue(resource);
+    Stopwatch watch;
+    restore_queue(path, resource, queue);
+    print_time(label, watch.elapsed_ns(), std::filesystem::file_size(path));
+    do_not_optimize(queue.front());
+}
+
+}  // namespace
+
+// Compares rebuilding a queue of 1 Mi records with restoring a snapshot of queue and resource.
+// Run it twice to compare a cold page cache with a warm one.
+int main(int argc, char** argv) {
+    const std::filesystem::path directory = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    const std::filesystem::path path = directory / ("pmr_snapshot_bench_" + std::to_string(::getpid()) + ".bin");
+    std::cout << "Restoring " << kElements << " x " << sizeof(Record) << "-byte records\n";
+    run_rebuild(path);
+    run_snapshot<PmrQueue<Record>>("restore PmrQueue (pointer fixups)", path, kElements, PmrQueue<Record>::node_size(),
+                                   [](CustomBlockMemoryResource& resource) { return PmrQueue<Record>(&resource); });
+    std::cout << "Restoring " << kCompactElements << " records one node per block\n";
+    run_snapshot<CompactPmrQueue<Record>>(
+        "restore CompactPmrQueue (no fixups)", path, kCompactElements, CompactPmrQueue<Record>::node_size(),
+        [](CustomBlockMemoryResource& resource) { return CompactPmrQueue<Record>(resource); });
+    std::filesystem::remove(path);
+    return 0;
+}
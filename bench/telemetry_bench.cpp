@@ -0,0 +1,73 @@
+#include "bench_common.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+#include "queue_telemetry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+
+namespace {
+
+constexpr std::size_t kRounds = 100000;
+constexpr std::size_t kBatch = 32;
+
+// Telemetry is off by default, so the plain queue must be the very same type.
+static_assert(std::is_same_v<PmrQueue<std::uint64_t>, PmrQueue<std::uint64_t, NoQueueTelemetry>>);
+
+// Fill/drain bursts with the node cache on, so the resource is out of the measured path.
+template <class Telemetry>
+void bench_queue(std::string_view name) {
+    using Queue = PmrQueue<std::uint64_t, Telemetry>;
+    CustomBlockMemoryResource buffer(1 << 16);
+    Queue queue(&buffer);
+    queue.set_node_cache_limit(kBatch);
+
+    // Bytes per node, measured on a queue whose cache is empty.
+    std::size_t node_bytes = 0;
+    {
+        Queue probe(&buffer);
+        const std::size_t before = buffer.used_bytes();
+        probe.push(0);
+        node_bytes = buffer.used_bytes() - before;
+    }
+
+    Stopwatch watch;
+    std::uint64_t checksum = 0;
+    for (std::size_t round = 0; round < kRounds; ++round) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            queue.push(i);
+        }
+        while (!queue.empty()) {
+            checksum += queue.front();
+            queue.pop();
+        }
+    }
+    const double ops = static_cast<double>(kRounds * kBatch);
+    const double ns_per_op = watch.elapsed_ns() / ops;
+    do_not_optimize(checksum);
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << ns_per_op << " ns/op" << std::setw(8) << node_bytes << " bytes/node\n";
+
+    if constexpr (Telemetry::enabled) {
+        const QueueTelemetrySnapshot snapshot = queue.telemetry().snapshot();
+        std::cout << "  sojourn ns p50 " << snapshot.sojourn_ns.value_at(0.5) << ", p99 "
+                  << snapshot.sojourn_ns.value_at(0.99) << ", p99.99 " << snapshot.sojourn_ns.value_at(0.9999)
+                  << ", max " << snapshot.sojourn_ns.max << "; depth p50 " << snapshot.depth_samples.value_at(0.5)
+                  << ", max " << snapshot.max_depth << "; " << std::setprecision(0) << snapshot.push_rate
+                  << " pushes/s\n";
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "PmrQueue<uint64_t>, bursts of " << kBatch << ", " << kRounds << " rounds\n";
+    bench_queue<NoQueueTelemetry>("plain push+pop");
+    bench_queue<QueueTelemetry>("QueueTelemetry push+pop");
+    bench_queue<NoQueueTelemetry>("plain push+pop (again)");
+    return 0;
+}
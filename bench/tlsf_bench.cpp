@@ -0,0 +1,130 @@
+#include "bench_common.hpp"
+#include "buddy_memory_resource.hpp"
+#include "memory_resource.hpp"
+#include "tlsf_memory_resource.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kCapacity = 1 << 22;
+
+struct Allocation {
+    void* ptr;
+    std::size_t size;
+};
+
+// Times one allocation; a failed one is recorded as a failure, not as a latency sample.
+template <class Resource>
+void* timed_allocate(Resource& resource, std::size_t size, std::vector<double>& samples, std::size_t& failures) {
+    const auto start = std::chrono::steady_clock::now();
+    void* ptr = nullptr;
+    try {
+        ptr = resource.allocate(size);
+    } catch (const std::bad_alloc&) {
+        ++failures;
+        return nullptr;
+    }
+    samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    return ptr;
+}
+
+void print_latency(std::string_view name, std::vector<double>& samples, std::size_t failures) {
+    const LatencyPercentiles result = latency_percentiles(samples);
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << result.p50 << std::setw(10) << result.p99 << std::setw(10) << result.p9999
+              << std::setw(12) << result.max << std::setw(10) << failures << '\n';
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(12) << "resource" << std::right << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p99 ns" << std::setw(10) << "p99.99 ns" << std::setw(12) << "max ns"
+              << std::setw(10) << "failures" << '\n';
+}
+
+// Checkerboard: thousands of small holes sit in front of the only gap that fits the probe size,
+// which is the worst case for a scanning allocator.
+template <class Resource>
+void run_checkerboard(std::string_view name, std::size_t live_blocks) {
+    Resource resource(kCapacity);
+    std::vector<void*> small;
+    small.reserve(live_blocks);
+    for (std::size_t i = 0; i < live_blocks; ++i) {
+        small.push_back(resource.allocate(48));
+    }
+    for (std::size_t i = 0; i < small.size(); i += 2) {
+        resource.deallocate(small[i], 48);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(20000);
+    std::size_t failures = 0;
+    for (std::size_t op = 0; op < 20000; ++op) {
+        if (void* probe = timed_allocate(resource, 200, samples, failures)) {
+            resource.deallocate(probe, 200);
+        }
+    }
+    print_latency(name, samples, failures);
+
+    for (std::size_t i = 1; i < small.size(); i += 2) {
+        resource.deallocate(small[i], 48);
+    }
+}
+
+// Random churn over a wide size range with a large live set, freed in random order.
+template <class Resource>
+void run_random_churn(std::string_view name) {
+    Resource resource(kCapacity);
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<std::size_t> size_dist(16, 1500);
+    std::vector<Allocation> live;
+    std::vector<double> samples;
+    samples.reserve(100000);
+    std::size_t failures = 0;
+
+    for (std::size_t op = 0; op < 100000; ++op) {
+        if (live.size() >= 2000) {
+            std::uniform_int_distribution<std::size_t> pick(0, live.size() - 1);
+            const std::size_t victim = pick(rng);
+            resource.deallocate(live[victim].ptr, live[victim].size);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        const std::size_t size = size_dist(rng);
+        if (void* ptr = timed_allocate(resource, size, samples, failures)) {
+            live.push_back({ptr, size});
+        }
+    }
+    print_latency(name, samples, failures);
+
+    for (const Allocation& allocation : live) {
+        resource.deallocate(allocation.ptr, allocation.size);
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Allocation latency over a " << kCapacity << "-byte buffer (steady_clock per call)\n";
+    for (std::size_t live_blocks : {1000u, 10000u, 40000u}) {
+        std::cout << "\nCheckerboard with " << live_blocks / 2 << " small holes, 200-byte probes\n";
+        print_header();
+        run_checkerboard<CustomBlockMemoryResource>("first-fit", live_blocks);
+        run_checkerboard<BuddyMemoryResource>("buddy", live_blocks);
+        run_checkerboard<TlsfMemoryResource>("tlsf", live_blocks);
+    }
+
+    std::cout << "\nRandom churn, 16..1500 bytes, ~2000 live blocks\n";
+    print_header();
+    run_random_churn<CustomBlockMemoryResource>("first-fit");
+    run_random_churn<BuddyMemoryResource>("buddy");
+    run_random_churn<TlsfMemoryResource>("tlsf");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "allocation_trace.hpp"
+#include "buddy_memory_resource.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+#include "tlsf_memory_resource.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Usage: trace_replay [trace-file]
+// Replays a trace recorded with RecordingMemoryResource against several resources. Without an
+// argument it records a synthetic PmrQueue<std::pmr::string> workload first.
+
+namespace {
+
+std::vector<AllocationTraceRecord> record_synthetic_trace() {
+    std::stringstream trace;
+    {
+        CustomBlockMemoryResource arena(1 << 22);
+        RecordingMemoryResource recorder(&arena, trace);
+        PmrQueue<std::pmr::string> queue(&recorder);
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<std::size_t> length(0, 200);
+        std::uniform_int_distribution<int> burst(1, 64);
+        for (int round = 0; round < 2000; ++round) {
+            for (int i = burst(rng); i > 0; --i) {
+                queue.emplace(length(rng), 'x');
+            }
+            for (int i = burst(rng); i > 0 && !queue.empty(); --i) {
+                queue.pop();
+            }
+        }
+    }
+    return read_allocation_trace(trace);
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(12) << "resource" << std::right << std::setw(12) << "Mops/s"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "p99.99 ns"
+              << std::setw(11) << "max ns" << std::setw(13) << "footprint" << std::setw(8) << "frag"
+              << std::setw(10) << "failures" << '\n';
+}
+
+void print_result(std::string_view name, const TraceReplayResult& result) {
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << result.ops_per_second / 1e6 << std::setprecision(0) << std::setw(10)
+              << result.latency_p50_ns << std::setw(10) << result.latency_p99_ns << std::setw(11)
+              << result.latency_p9999_ns << std::setw(11) << result.latency_max_ns << std::setw(13)
+              << result.peak_footprint_bytes << std::setprecision(3) << std::setw(8) << result.fragmentation
+              << std::setw(10) << result.failures << '\n';
+}
+
+template <class Resource>
+void replay_on(std::string_view name, const std::vector<AllocationTraceRecord>& records, std::size_t capacity) {
+    Resource resource(capacity);
+    print_result(name, replay_allocation_trace(records, resource));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<AllocationTraceRecord> records;
+    try {
+        if (argc > 1) {
+            std::ifstream in(argv[1], std::ios::binary);
+            if (!in) {
+                std::cerr << "Cannot open " << argv[1] << '\n';
+                return 1;
+            }
+            records = read_allocation_trace(in);
+        } else {
+            records = record_synthetic_trace();
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    // The heap run sizes the fixed-buffer resources with generous headroom.
+    const TraceReplayResult heap = replay_allocation_trace(records, *std::pmr::new_delete_resource());
+    const std::size_t capacity = std::bit_ceil(heap.peak_live_bytes * 4 + (1 << 16));
+
+    std::cout << records.size() << " events, peak live " << heap.peak_live_bytes << " bytes, arena capacity "
+              << capacity << " bytes\n";
+    print_header();
+    print_result("new/delete", heap);
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        print_result("pool", replay_allocation_trace(records, pool));
+    }
+    replay_on<CustomBlockMemoryResource>("first-fit", records, capacity);
+    replay_on<BestFitBlockMemoryResource>("best-fit", records, capacity);
+    replay_on<BuddyMemoryResource>("buddy", records, capacity);
+    replay_on<TlsfMemoryResource>("tlsf", records, capacity);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "bench_common.hpp"
+#include "durable_pmr_queue.hpp"
+#include "memory_resource.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kMessagesPerRun = 20000;
+
+struct Message {
+    std::uint64_t id;
+    std::uint64_t payload[7];
+};
+
+void print_result(const std::string& label, std::size_t messages, double elapsed_ns, const DurableQueueStats& stats) {
+    const double per_second = static_cast<double>(messages) * 1e9 / elapsed_ns;
+    const double per_commit = stats.group_commits == 0 ? 0.0
+                                                       : static_cast<double>(stats.appends) /
+                                                             static_cast<double>(stats.group_commits);
+    std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(0)
+              << std::setw(12) << per_second << " msg/s" << std::setprecision(1) << std::setw(10) << per_commit
+              << " records/fsync\n";
+}
+
+// One producer hands the log `batch` records per push_bulk call, so every call costs one fsync.
+void run_batched(const std::filesystem::path& directory, std::size_t batch) {
+    std::filesystem::remove_all(directory);
+    CustomBlockMemoryResource resource(kMessagesPerRun * 256);
+    DurablePmrQueue<Message> queue(&resource, DurableQueueOptions{directory});
+    std::vector<Message> messages(batch);
+    Stopwatch watch;
+    for (std::size_t sent = 0; sent < kMessagesPerRun; sent += batch) {
+        for (std::size_t i = 0; i < batch; ++i) {
+            messages[i].id = sent + i;
+        }
+        queue.push_bulk(messages.begin(), messages.end());
+        Message received{};
+        while (queue.try_pop(received)) {
+            do_not_optimize(received);
+        }
+    }
+    print_result("push_bulk batch " + std::to_string(batch), kMessagesPerRun, watch.elapsed_ns(), queue.stats());
+}
+
+// Concurrent single-record pushes drained by the main thread; group commit decides how many
+// records share an fsync.
+void run_producers(const std::filesystem::path& directory, std::size_t producers) {
+    std::filesystem::remove_all(directory);
+    CustomBlockMemoryResource resource(kMessagesPerRun * 256);
+    DurablePmrQueue<Message> queue(&resource, DurableQueueOptions{directory});
+    const std::size_t per_producer = kMessagesPerRun / producers;
+    Stopwatch watch;
+    std::vector<std::thread> threads;
+    for (std::size_t producer = 0; producer < producers; ++producer) {
+        threads.emplace_back([&queue, producer, per_producer] {
+            Message message{};
+            for (std::size_t i = 0; i < per_producer; ++i) {
+                message.id = producer * per_producer + i;
+                queue.push(message);
+            }
+        });
+    }
+    std::size_t received_count = 0;
+    Message received{};
+    while (received_count < per_producer * producers) {
+        if (queue.pop_for(received, std::chrono::milliseconds(10))) {
+            do_not_optimize(received);
+            ++received_count;
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    print_result("push, " + std::to_string(producers) + " producers", per_producer * producers, watch.elapsed_ns(),
+                 queue.stats());
+}
+
+}  // namespace
+
+// Usage: wal_bench [directory]. Point it at the device under test; the default is the
+// system temporary directory, which may be a tmpfs where fsync is nearly free. The logs go
+// into a private subdirectory that is removed afterwards; `directory` itself is left alone.
+int main(int argc, char** argv) {
+    const std::filesystem::path parent = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path();
+    const std::filesystem::path directory = parent / ("pmr_wal_bench_" + std::to_string(::getpid()));
+    std::cout << "Durable push throughput, " << kMessagesPerRun << " x " << sizeof(Message)
+              << "-byte messages in " << directory << "\n";
+    for (const std::size_t batch : {1, 4, 16, 64, 256}) {
+        run_batched(directory, batch);
+    }
+    for (const std::size_t producers : {1, 2, 4, 8}) {
+        run_producers(directory, producers);
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
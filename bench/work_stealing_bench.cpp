@@ -0,0 +1,105 @@
+#include "bench_common.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Task {
+    std::pmr::string title;
+    int priority;
+    double weight;
+};
+
+long serial_fib(int n) {
+    return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+long parallel_fib(WorkStealingPool& pool, int n) {
+    if (n < 18) {
+        return serial_fib(n);
+    }
+    long left = 0;
+    TaskGroup group(pool);
+    group.run([&pool, &left, n] { left = parallel_fib(pool, n - 1); });
+    const long right = parallel_fib(pool, n - 2);
+    group.wait();
+    return left + right;
+}
+
+// Stand-in for per-task work whose cost grows with the task weight.
+double process(const Task& task) {
+    double acc = 0;
+    const int steps = static_cast<int>(task.weight * 2000);
+    for (int i = 1; i <= steps; ++i) {
+        acc += std::sqrt(static_cast<double>(i * task.priority));
+    }
+    return acc;
+}
+
+void bench_fork_join(std::size_t workers) {
+    constexpr int n = 30;
+    Stopwatch watch;
+    const long expected = serial_fib(n);
+    const double serial_ms = watch.elapsed_ns() / 1e6;
+
+    WorkStealingPool pool(workers);
+    watch.restart();
+    const long result = parallel_fib(pool, n);
+    const double parallel_ms = watch.elapsed_ns() / 1e6;
+    do_not_optimize(result);
+
+    std::cout << "fork-join fib(" << n << ")  workers=" << workers << "  serial " << serial_ms << " ms, pool "
+              << parallel_ms << " ms" << (result == expected ? "" : "  MISMATCH") << "\n";
+}
+
+void bench_parallel_map(std::size_t workers) {
+    std::pmr::monotonic_buffer_resource strings;
+    std::vector<Task> tasks;
+    for (int i = 0; i < 20000; ++i) {
+        tasks.push_back(Task{std::pmr::string("task-" + std::to_string(i), &strings), 1 + i % 5,
+                             0.5 + (i % 7) * 0.25});
+    }
+    std::vector<double> results(tasks.size());
+
+    Stopwatch watch;
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        results[i] = process(tasks[i]);
+    }
+    const double serial_ms = watch.elapsed_ns() / 1e6;
+
+    WorkStealingPool pool(workers);
+    constexpr std::size_t chunk = 64;
+    watch.restart();
+    for (std::size_t begin = 0; begin < tasks.size(); begin += chunk) {
+        pool.submit([&tasks, &results, begin] {
+            const std::size_t end = std::min(begin + chunk, tasks.size());
+            for (std::size_t i = begin; i < end; ++i) {
+                results[i] = process(tasks[i]);
+            }
+        });
+    }
+    pool.wait_idle();
+    const double parallel_ms = watch.elapsed_ns() / 1e6;
+    do_not_optimize(results.back());
+
+    std::cout << "parallel map over " << tasks.size() << " Task weights  workers=" << workers << "  serial "
+              << serial_ms << " ms, pool " << parallel_ms << " ms\n";
+}
+
+}  // namespace
+
+int main() {
+    const std::size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    bench_fork_join(workers);
+    bench_parallel_map(workers);
+    return 0;
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class AllocationEventKind : std::uint8_t { allocate = 0, deallocate = 1 };
+
+// One recorded call. `allocation_id` pairs a deallocation with the allocation it releases.
+struct AllocationTraceRecord {
+    std::uint64_t timestamp_ns{0};
+    std::uint64_t size{0};
+    std::uint32_t allocation_id{0};
+    std::uint16_t thread{0};
+    AllocationEventKind kind{AllocationEventKind::allocate};
+    std::uint8_t alignment_log2{0};
+
+    std::size_t alignment() const noexcept { return std::size_t{1} << alignment_log2; }
+};
+
+// On-disk layout: an 8-byte magic followed by fixed 24-byte little-endian records.
+namespace allocation_trace_format {
+
+inline constexpr std::array<char, 8> kMagic{'P', 'M', 'R', 'T', 'R', 'C', '0', '1'};
+inline constexpr std::size_t kRecordBytes = 24;
+
+template <class Integer>
+void store(std::byte* out, Integer value) noexcept {
+    for (std::size_t i = 0; i < sizeof(Integer); ++i) {
+        out[i] = static_cast<std::byte>(static_cast<std::uint64_t>(value) >> (8 * i));
+    }
+}
+
+template <class Integer>
+Integer load(const std::byte* in) noexcept {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(Integer); ++i) {
+        value |= static_cast<std::uint64_t>(in[i]) << (8 * i);
+    }
+    return static_cast<Integer>(value);
+}
+
+inline void encode(const AllocationTraceRecord& record, std::byte* out) noexcept {
+    store(out, record.timestamp_ns);
+    store(out + 8, record.size);
+    store(out + 16, record.allocation_id);
+    store(out + 20, record.thread);
+    out[22] = static_cast<std::byte>(record.kind);
+    out[23] = static_cast<std::byte>(record.alignment_log2);
+}
+
+inline AllocationTraceRecord decode(const std::byte* in) {
+    AllocationTraceRecord record;
+    record.timestamp_ns = load<std::uint64_t>(in);
+    record.size = load<std::uint64_t>(in + 8);
+    record.allocation_id = load<std::uint32_t>(in + 16);
+    record.thread = load<std::uint16_t>(in + 20);
+    const auto kind = static_cast<std::uint8_t>(in[22]);
+    if (kind > static_cast<std::uint8_t>(AllocationEventKind::deallocate) || static_cast<std::uint8_t>(in[23]) >= 64) {
+        throw std::runtime_error("Corrupted allocation trace record");
+    }
+    record.kind = static_cast<AllocationEventKind>(kind);
+    record.alignment_log2 = static_cast<std::uint8_t>(in[23]);
+    return record;
+}
+
+}  // namespace allocation_trace_format
+
+// Forwards every call to an upstream resource (typically a CustomBlockMemoryResource) and
+// appends it to a binary trace: size, alignment, time since construction and a small per-thread
+// index. Records are buffered and written to the stream in chunks, on flush() and on
+// destruction. The recorder itself is synchronized, so it also captures multi-threaded traffic
+// as long as the upstream is safe to share.
+class RecordingMemoryResource : public std::pmr::memory_resource {
+public:
+    RecordingMemoryResource(std::pmr::memory_resource* upstream, std::ostream& out,
+                            std::size_t flush_threshold_bytes = 1 << 16)
+        : upstream_(upstream), out_(out), flush_threshold_(flush_threshold_bytes), start_(clock::now()) {
+        if (upstream == nullptr) {
+            throw std::invalid_argument("Upstream resource must not be null");
+        }
+        out_.write(allocation_trace_format::kMagic.data(), allocation_trace_format::kMagic.size());
+    }
+
+    RecordingMemoryResource(const RecordingMemoryResource&) = delete;
+    RecordingMemoryResource& operator=(const RecordingMemoryResource&) = delete;
+
+    ~RecordingMemoryResource() override {
+        flush();
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept { return upstream_; }
+
+    std::size_t recorded_events() const {
+        std::lock_guard lock(mutex_);
+        return recorded_;
+    }
+
+    void flush() {
+        std::lock_guard lock(mutex_);
+        write_pending();
+        out_.flush();
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    std::pmr::memory_resource* upstream_;
+    std::ostream& out_;
+    std::size_t flush_threshold_;
+    clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::vector<std::byte> pending_;
+    std::unordered_map<void*, std::uint32_t> live_ids_;
+    std::unordered_map<std::thread::id, std::uint16_t> thread_ids_;
+    std::uint32_t next_id_{0};
+    std::size_t recorded_{0};
+
+    void write_pending() {
+        out_.write(reinterpret_cast<const char*>(pending_.data()), static_cast<std::streamsize>(pending_.size()));
+        pending_.clear();
+    }
+
+    void append(AllocationEventKind kind, std::uint32_t id, std::size_t bytes, std::size_t alignment) {
+        AllocationTraceRecord record;
+        record.timestamp_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+        record.size = bytes;
+        record.allocation_id = id;
+        record.thread = thread_ids_.try_emplace(std::this_thread::get_id(),
+                                                static_cast<std::uint16_t>(thread_ids_.size())).first->second;
+        record.kind = kind;
+        record.alignment_log2 = static_cast<std::uint8_t>(std::countr_zero(alignment == 0 ? alignof(std::max_align_t) : alignment));
+
+        const std::size_t offset = pending_.size();
+        pending_.resize(offset + allocation_trace_format::kRecordBytes);
+        allocation_trace_format::encode(record, pending_.data() + offset);
+        ++recorded_;
+        if (pending_.size() >= flush_threshold_) {
+            write_pending();
+        }
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* ptr = upstream_->allocate(bytes, alignment);
+        std::lock_guard lock(mutex_);
+        const std::uint32_t id = next_id_++;
+        live_ids_[ptr] = id;
+        append(AllocationEventKind::allocate, id, bytes, alignment);
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+        {
+            std::lock_guard lock(mutex_);
+            // Blocks obtained before recording started are forwarded but not traced.
+            if (const auto it = live_ids_.find(ptr); it != live_ids_.end()) {
+                append(AllocationEventKind::deallocate, it->second, bytes, alignment);
+                live_ids_.erase(it);
+            }
+        }
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Reads a whole trace written by RecordingMemoryResource.
+inline std::vector<AllocationTraceRecord> read_allocation_trace(std::istream& in) {
+    std::array<char, allocation_trace_format::kMagic.size()> magic{};
+    if (!in.read(magic.data(), magic.size()) || magic != allocation_trace_format::kMagic) {
+        throw std::runtime_error("Not an allocation trace");
+    }
+    std::vector<AllocationTraceRecord> records;
+    std::array<std::byte, allocation_trace_format::kRecordBytes> buffer{};
+    while (in.read(reinterpret_cast<char*>(buffer.data()), buffer.size())) {
+        records.push_back(allocation_trace_format::decode(buffer.data()));
+    }
+    if (in.gcount() != 0) {
+        throw std::runtime_error("Truncated allocation trace");
+    }
+    return records;
+}
+
+// Outcome of replaying a trace. Latencies are per allocate call; the footprint is the address
+// span covered by live blocks, so it is only meaningful for resources that carve one region.
+struct TraceReplayResult {
+    std::size_t allocations{0};
+    std::size_t deallocations{0};
+    std::size_t failures{0};
+    double elapsed_ns{0};
+    double ops_per_second{0};
+    double latency_p50_ns{0};
+    double latency_p99_ns{0};
+    double latency_p9999_ns{0};
+    double latency_max_ns{0};
+    std::size_t peak_live_bytes{0};
+    std::size_t peak_footprint_bytes{0};
+    double fragmentation{0};
+};
+
+// Replays the calls in trace order on one thread against `resource`. Allocations that fail
+// with std::bad_alloc are counted and their matching deallocations skipped. Fragmentation is
+// the share of the peak footprint not covered by the peak of live bytes.
+inline TraceReplayResult replay_allocation_trace(const std::vector<AllocationTraceRecord>& records,
+                                                 std::pmr::memory_resource& resource) {
+    using clock = std::chrono::steady_clock;
+    struct LiveBlock {
+        void* ptr{nullptr};
+        std::size_t size{0};
+        std::size_t alignment{0};
+    };
+
+    TraceReplayResult result;
+    std::uint32_t max_id = 0;
+    for (const AllocationTraceRecord& record : records) {
+        max_id = std::max(max_id, record.allocation_id);
+    }
+    std::vector<LiveBlock> live(records.empty() ? 0 : std::size_t{max_id} + 1);
+    std::vector<double> latencies;
+    latencies.reserve(records.size());
+
+    std::uintptr_t lowest = UINTPTR_MAX;
+    std::uintptr_t highest = 0;
+    std::size_t live_bytes = 0;
+
+    const clock::time_point start = clock::now();
+    for (const AllocationTraceRecord& record : records) {
+        LiveBlock& block = live[record.allocation_id];
+        if (record.kind == AllocationEventKind::allocate) {
+            const clock::time_point call = clock::now();
+            try {
+                block.ptr = resource.allocate(record.size, record.alignment());
+            } catch (const std::bad_alloc&) {
+                ++result.failures;
+                continue;
+            }
+            latencies.push_back(std::chrono::duration<double, std::nano>(clock::now() - call).count());
+            block.size = record.size;
+            block.alignment = record.alignment();
+            ++result.allocations;
+
+            const auto begin = reinterpret_cast<std::uintptr_t>(block.ptr);
+            lowest = std::min(lowest, begin);
+            highest = std::max(highest, begin + record.size);
+            live_bytes += record.size;
+            result.peak_live_bytes = std::max(result.peak_live_bytes, live_bytes);
+            result.peak_footprint_bytes = std::max(result.peak_footprint_bytes, static_cast<std::size_t>(highest - lowest));
+        } else if (block.ptr != nullptr) {
+            resource.deallocate(block.ptr, block.size, block.alignment);
+            live_bytes -= block.size;
+            block = {};
+            ++result.deallocations;
+        }
+    }
+    result.elapsed_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+    for (const LiveBlock& block : live) {
+        if (block.ptr != nullptr) {
+            resource.deallocate(block.ptr, block.size, block.alignment);
+        }
+    }
+
+    const std::size_t operations = result.allocations + result.deallocations;
+    result.ops_per_second = result.elapsed_ns == 0 ? 0.0 : operations * 1e9 / result.elapsed_ns;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        const auto rank = [&](double fraction) {
+            return latencies[static_cast<std::size_t>(fraction * static_cast<double>(latencies.size() - 1))];
+        };
+        result.latency_p50_ns = rank(0.50);
+        result.latency_p99_ns = rank(0.99);
+        result.latency_p9999_ns = rank(0.9999);
+        result.latency_max_ns = latencies.back();
+    }
+    result.fragmentation = result.peak_footprint_bytes == 0
+        ? 0.0
+        : 1.0 - static_cast<double>(result.peak_live_bytes) / result.peak_footprint_bytes;
+    return result;
+}
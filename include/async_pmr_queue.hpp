@@ -0,0 +1,257 @@
+#pragma once
+
+#include "intrusive_queue.hpp"
+#include "pmr_queue.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Decides where a coroutine woken by AsyncPmrQueue::push is resumed.
+class AsyncExecutor {
+public:
+    virtual ~AsyncExecutor() = default;
+    virtual void schedule(std::coroutine_handle<> handle) = 0;
+};
+
+// Resumes the consumer on the pushing thread, inside push().
+class InlineExecutor : public AsyncExecutor {
+public:
+    void schedule(std::coroutine_handle<> handle) override { handle.resume(); }
+};
+
+// Collects woken coroutines until the owner calls run_pending(), typically from an event loop.
+class ManualExecutor : public AsyncExecutor {
+public:
+    explicit ManualExecutor(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource), ready_(resource) {}
+
+    void schedule(std::coroutine_handle<> handle) override {
+        std::lock_guard lock(mutex_);
+        ready_.push(handle);
+    }
+
+    // Resumes every coroutine scheduled so far and returns how many were resumed.
+    std::size_t run_pending() {
+        PmrQueue<std::coroutine_handle<>> batch(resource_);
+        {
+            std::lock_guard lock(mutex_);
+            batch.splice(ready_);
+        }
+        std::size_t resumed = 0;
+        for (;; ++resumed) {
+            std::coroutine_handle<> handle;
+            {
+                // The resource is shared with schedule(), so nodes are released under the lock.
+                std::lock_guard lock(mutex_);
+                if (batch.empty()) {
+                    break;
+                }
+                handle = batch.front();
+                batch.pop();
+            }
+            handle.resume();
+        }
+        return resumed;
+    }
+
+private:
+    std::pmr::memory_resource* resource_;
+    std::mutex mutex_;
+    PmrQueue<std::coroutine_handle<>> ready_;
+};
+
+// Fire-and-forget coroutine whose frame is allocated from a std::pmr::memory_resource.
+// Pass `std::allocator_arg, resource` as the first two coroutine arguments, or right after
+// the object for member coroutines, to choose the resource; `resource` may point to any class
+// derived from std::pmr::memory_resource. Otherwise the default resource is used. A signature
+// that passes std::allocator_arg in any other shape does not compile rather than silently
+// falling back to the default resource.
+class PmrTask {
+    struct promise_base {
+        PmrTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        // The owning resource is stored right after the frame so delete can find it.
+        static std::size_t resource_offset(std::size_t size) noexcept {
+            constexpr std::size_t alignment = alignof(std::pmr::memory_resource*);
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        static void* allocate_frame(std::size_t size, std::pmr::memory_resource* resource) {
+            void* frame = resource->allocate(resource_offset(size) + sizeof(resource), alignof(std::max_align_t));
+            std::memcpy(static_cast<std::byte*>(frame) + resource_offset(size), &resource, sizeof(resource));
+            return frame;
+        }
+
+        static void deallocate_frame(void* frame, std::size_t size) {
+            std::pmr::memory_resource* resource = nullptr;
+            std::memcpy(&resource, static_cast<std::byte*>(frame) + resource_offset(size), sizeof(resource));
+            resource->deallocate(frame, resource_offset(size) + sizeof(resource), alignof(std::max_align_t));
+        }
+
+        // The resource is the argument that follows std::allocator_arg.
+        template <class First, class... Rest>
+        static std::pmr::memory_resource* resource_of(First&, Rest&... rest) noexcept {
+            if constexpr (std::is_same_v<std::remove_cvref_t<First>, std::allocator_arg_t>) {
+                return std::get<0>(std::tie(rest...));
+            } else {
+                return resource_of(rest...);
+            }
+        }
+    };
+
+public:
+    // Promise for coroutines with the parameters `Params`, selected by the coroutine_traits
+    // below. Its operator new is an ordinary member, so it pairs with operator delete.
+    template <class... Params>
+    struct basic_promise : promise_base {
+        static void* operator new(std::size_t size, Params&... params) {
+            return allocate_frame(size, resource_of(params...));
+        }
+
+        static void operator delete(void* frame, std::size_t size) { deallocate_frame(frame, size); }
+    };
+
+    struct promise_type : promise_base {
+        static void* operator new(std::size_t size) {
+            return allocate_frame(size, std::pmr::get_default_resource());
+        }
+
+        // Chosen only for std::allocator_arg signatures the specializations do not cover. GCC
+        // falls back to operator new(size_t) past a deleted overload, hence the static_assert.
+        template <class... Args>
+        static void* operator new(std::size_t, std::allocator_arg_t, Args&&...) {
+            static_assert(sizeof...(Args) < 0, "Pass the resource as a pointer right after std::allocator_arg");
+            std::terminate();
+        }
+        template <class Object, class... Args>
+        static void* operator new(std::size_t, Object&, std::allocator_arg_t, Args&&...) {
+            static_assert(sizeof...(Args) < 0, "Pass the resource as a pointer right after std::allocator_arg");
+            std::terminate();
+        }
+
+        static void operator delete(void* frame, std::size_t size) { deallocate_frame(frame, size); }
+    };
+};
+
+template <class Resource, class... Args>
+    requires std::is_convertible_v<Resource*, std::pmr::memory_resource*>
+struct std::coroutine_traits<PmrTask, std::allocator_arg_t, Resource*, Args...> {
+    using promise_type = PmrTask::basic_promise<std::allocator_arg_t, Resource*, Args...>;
+};
+
+// Member coroutines see the implicit object parameter first.
+template <class Object, class Resource, class... Args>
+    requires std::is_reference_v<Object> && std::is_convertible_v<Resource*, std::pmr::memory_resource*>
+struct std::coroutine_traits<PmrTask, Object, std::allocator_arg_t, Resource*, Args...> {
+    using promise_type = PmrTask::basic_promise<Object, std::allocator_arg_t, Resource*, Args...>;
+};
+
+// Single-resource queue whose consumers are coroutines: `co_await queue.pop()` suspends until
+// an element is available. push() hands the element straight to the oldest waiting consumer
+// and resumes it through the executor. Waiters are linked intrusively through their awaiter,
+// which lives in the coroutine frame, so awaiting never allocates.
+template <class T>
+class AsyncPmrQueue {
+public:
+    using value_type = T;
+
+    class PopAwaiter {
+    public:
+        explicit PopAwaiter(AsyncPmrQueue& queue) : queue_(&queue) {}
+
+        PopAwaiter(const PopAwaiter&) = delete;
+        PopAwaiter& operator=(const PopAwaiter&) = delete;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard lock(queue_->mutex_);
+            if (!queue_->elements_.empty()) {
+                slot_.emplace(std::move(queue_->elements_.front()));
+                queue_->elements_.pop();
+                return false;
+            }
+            handle_ = handle;
+            queue_->waiters_.push(*this);
+            return true;
+        }
+
+        T await_resume() { return std::move(*slot_); }
+
+        IntrusiveQueueHook<PopAwaiter> queue_hook;
+
+    private:
+        friend class AsyncPmrQueue;
+
+        AsyncPmrQueue* queue_;
+        std::optional<T> slot_;
+        std::coroutine_handle<> handle_;
+    };
+
+    AsyncPmrQueue(AsyncExecutor& executor, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : executor_(&executor), elements_(resource) {}
+
+    AsyncPmrQueue(const AsyncPmrQueue&) = delete;
+    AsyncPmrQueue& operator=(const AsyncPmrQueue&) = delete;
+
+    // Consumers still suspended in pop() must be resumed before the queue is destroyed.
+    ~AsyncPmrQueue() = default;
+
+    template <class... Args>
+    void emplace(Args&&... args) {
+        std::unique_lock lock(mutex_);
+        if (waiters_.empty()) {
+            elements_.emplace(std::forward<Args>(args)...);
+            return;
+        }
+        PopAwaiter& waiter = waiters_.front();
+        waiters_.pop();
+        lock.unlock();
+        waiter.slot_.emplace(std::forward<Args>(args)...);
+        executor_->schedule(waiter.handle_);
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    [[nodiscard]] PopAwaiter pop() { return PopAwaiter(*this); }
+
+    bool try_pop(T& out) {
+        std::lock_guard lock(mutex_);
+        if (elements_.empty()) {
+            return false;
+        }
+        out = std::move(elements_.front());
+        elements_.pop();
+        return true;
+    }
+
+    bool empty() const {
+        std::lock_guard lock(mutex_);
+        return elements_.empty();
+    }
+
+    std::size_t waiting_consumers() const {
+        std::lock_guard lock(mutex_);
+        return waiters_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    AsyncExecutor* executor_;
+    PmrQueue<T> elements_;
+    IntrusiveQueue<PopAwaiter> waiters_;
+};
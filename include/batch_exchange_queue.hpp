@@ -0,0 +1,195 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+#include "queue_telemetry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+// Single-producer/single-consumer handoff that synchronizes per batch instead of per element.
+// The producer fills a private PmrQueue; once it holds `batch_size` elements, or the oldest of
+// them has waited `flush_timeout`, the whole batch is spliced onto the shared queue under one
+// lock acquisition. The consumer takes everything published so far with one splice into its
+// own PmrQueue. The deadline is measured with TscClock from the first element of a batch and
+// checked by the consumer: take() and take_for() also pull a partial batch that is past its
+// deadline, so a producer that goes idle does not hold elements back. The producer reads the
+// clock once per batch and locks the filling queue's own mutex on every push; the consumer
+// reads the batch start from an atomic and takes that mutex only to pull an overdue batch,
+// so the producer's lock is uncontended otherwise.
+// Nodes are allocated by the producer and freed by the consumer, so the resource must be
+// thread-safe, e.g. a SynchronizedMemoryResource.
+template <class T>
+class BatchExchangeQueue {
+public:
+    using value_type = T;
+
+    explicit BatchExchangeQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                                std::size_t batch_size = 256,
+                                std::chrono::nanoseconds flush_timeout = std::chrono::milliseconds(1))
+        : filling_(resource),
+          ready_(resource),
+          batch_size_(batch_size),
+          timeout_ticks_(static_cast<std::uint64_t>(static_cast<double>(flush_timeout.count()) / TscClock::ns_per_tick())) {
+        if (batch_size == 0) {
+            throw std::invalid_argument("Batch size must be greater than zero");
+        }
+    }
+
+    BatchExchangeQueue(const BatchExchangeQueue&) = delete;
+    BatchExchangeQueue& operator=(const BatchExchangeQueue&) = delete;
+
+    // Producer only.
+    template <class... Args>
+    void emplace(Args&&... args) {
+        bool due = false;
+        {
+            std::lock_guard lock(filling_mutex_);
+            const bool first = filling_.empty();
+            filling_.emplace(std::forward<Args>(args)...);
+            if (first) {
+                batch_started_.store(std::max<std::uint64_t>(TscClock::now(), 1), std::memory_order_relaxed);
+            }
+            due = filling_.size() >= batch_size_;
+        }
+        if (due) {
+            publish(false);
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // Producer only. Publishes the partial batch, if any.
+    void flush() { publish(false); }
+
+    // Producer only. Publishes the partial batch if its oldest element has waited too long.
+    bool flush_if_due() { return publish(true); }
+
+    // Producer only. Publishes what is left and lets a waiting consumer return.
+    void close() {
+        flush();
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+        }
+        published_.notify_one();
+    }
+
+    // Consumer only. Appends every published element, and an overdue partial batch, to `out`
+    // and returns how many.
+    std::size_t take(PmrQueue<T>& out) {
+        if (overdue(TscClock::now())) {
+            std::scoped_lock lock(filling_mutex_, mutex_);
+            return take_locked(out, true);
+        }
+        std::lock_guard lock(mutex_);
+        return take_locked(out, false);
+    }
+
+    // Consumer only. Waits up to `timeout` for a batch, waking when the producer's partial
+    // batch falls due; returns 0 on timeout or once closed and drained.
+    template <class Rep, class Period>
+    std::size_t take_for(PmrQueue<T>& out, const std::chrono::duration<Rep, Period>& timeout) {
+        using clock = std::chrono::steady_clock;
+        const clock::time_point deadline = clock::now() + std::chrono::ceil<clock::duration>(timeout);
+        std::unique_lock lock(mutex_);
+        while (true) {
+            const std::uint64_t ticks = TscClock::now();
+            if (overdue(ticks)) {
+                lock.unlock();
+                std::scoped_lock both(filling_mutex_, mutex_);
+                return take_locked(out, true);
+            }
+            if (closed_ || !ready_.empty()) {
+                return take_locked(out, false);
+            }
+            const clock::time_point now = clock::now();
+            if (now >= deadline) {
+                return 0;
+            }
+            clock::time_point wake = deadline;
+            const std::uint64_t started = batch_started_.load(std::memory_order_relaxed);
+            if (started != 0) {
+                const std::uint64_t elapsed = ticks > started ? ticks - started : 0;
+                const std::uint64_t due_ticks = elapsed < timeout_ticks_ ? timeout_ticks_ - elapsed : 0;
+                wake = std::min(wake, now + std::chrono::nanoseconds(TscClock::to_ns(due_ticks)));
+            }
+            consumer_waiting_ = true;
+            published_.wait_until(lock, wake, [this] { return closed_ || !ready_.empty(); });
+            consumer_waiting_ = false;
+        }
+    }
+
+    bool closed() const {
+        std::lock_guard lock(mutex_);
+        return closed_ && ready_.empty();
+    }
+
+    std::size_t batch_size() const noexcept { return batch_size_; }
+
+    // Batches handed over, whether published by the producer or pulled by the consumer.
+    std::uint64_t batches_published() const {
+        std::lock_guard lock(mutex_);
+        return batches_published_;
+    }
+
+private:
+    // Lock order: filling_mutex_ before mutex_.
+    std::mutex filling_mutex_;
+    mutable std::mutex mutex_;
+    std::condition_variable published_;
+    PmrQueue<T> filling_;
+    PmrQueue<T> ready_;
+    std::size_t batch_size_;
+    std::uint64_t timeout_ticks_;
+    // TscClock reading at the first element of the filling batch, 0 while it is empty.
+    // Written under filling_mutex_, read by the consumer without it.
+    std::atomic<std::uint64_t> batch_started_{0};
+    std::uint64_t batches_published_{0};
+    bool consumer_waiting_{false};
+    bool closed_{false};
+
+    bool overdue(std::uint64_t ticks) const noexcept {
+        const std::uint64_t started = batch_started_.load(std::memory_order_relaxed);
+        return started != 0 && ticks >= started && ticks - started >= timeout_ticks_;
+    }
+
+    bool publish(bool only_if_due) {
+        bool consumer_parked = false;
+        {
+            std::scoped_lock lock(filling_mutex_, mutex_);
+            if (filling_.empty() || (only_if_due && !overdue(TscClock::now()))) {
+                return false;
+            }
+            ready_.splice(filling_);
+            batch_started_.store(0, std::memory_order_relaxed);
+            ++batches_published_;
+            consumer_parked = consumer_waiting_;
+        }
+        if (consumer_parked) {
+            published_.notify_one();
+        }
+        return true;
+    }
+
+    // `filling_locked` says the caller also holds filling_mutex_ and may pull an overdue batch.
+    std::size_t take_locked(PmrQueue<T>& out, bool filling_locked) {
+        std::size_t taken = ready_.size();
+        out.splice(ready_);
+        if (filling_locked && overdue(TscClock::now())) {
+            taken += filling_.size();
+            out.splice(filling_);
+            batch_started_.store(0, std::memory_order_relaxed);
+            ++batches_published_;
+        }
+        return taken;
+    }
+};
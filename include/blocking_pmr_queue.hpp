@@ -0,0 +1,191 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+// Bounded multi-producer/multi-consumer queue over PmrQueue. Producers block while the queue
+// is full, consumers block while it is empty, and close() releases everyone for shutdown.
+// Waiters are counted so a push or pop signals only when someone is actually parked, and a
+// bulk push wakes at most as many consumers as it published elements.
+template <class T>
+class BlockingPmrQueue {
+public:
+    using value_type = T;
+
+    explicit BlockingPmrQueue(std::size_t capacity,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : queue_(resource), capacity_(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Capacity must be greater than zero");
+        }
+    }
+
+    BlockingPmrQueue(const BlockingPmrQueue&) = delete;
+    BlockingPmrQueue& operator=(const BlockingPmrQueue&) = delete;
+
+    // Blocks while the queue is full. Returns false if the queue was closed.
+    bool push(T value) {
+        std::unique_lock lock(mutex_);
+        wait_not_full(lock);
+        return enqueue(lock, std::move(value));
+    }
+
+    bool try_push(T value) {
+        std::unique_lock lock(mutex_);
+        if (closed_ || size_ == capacity_) {
+            return false;
+        }
+        return enqueue(lock, std::move(value));
+    }
+
+    template <class Rep, class Period>
+    bool push_for(T value, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock lock(mutex_);
+        if (!wait_not_full_until(lock, std::chrono::steady_clock::now() + timeout)) {
+            return false;
+        }
+        return enqueue(lock, std::move(value));
+    }
+
+    // Pushes [first, last) in order, blocking for space as needed. Returns the number of
+    // elements published before the queue was closed.
+    template <class InputIt>
+    std::size_t push_bulk(InputIt first, InputIt last) {
+        std::size_t published = 0;
+        std::unique_lock lock(mutex_);
+        while (first != last) {
+            wait_not_full(lock);
+            if (closed_) {
+                break;
+            }
+            std::size_t batch = 0;
+            while (first != last && size_ < capacity_) {
+                queue_.push(*first);
+                ++first;
+                ++size_;
+                ++batch;
+            }
+            published += batch;
+            wake_consumers(batch);
+        }
+        return published;
+    }
+
+    // Blocks while the queue is empty. Returns false once the queue is closed and drained.
+    bool pop(T& out) {
+        std::unique_lock lock(mutex_);
+        wait_not_empty(lock);
+        return dequeue(out);
+    }
+
+    bool try_pop(T& out) {
+        std::unique_lock lock(mutex_);
+        return dequeue(out);
+    }
+
+    template <class Rep, class Period>
+    bool pop_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock lock(mutex_);
+        wait_not_empty_until(lock, std::chrono::steady_clock::now() + timeout);
+        return dequeue(out);
+    }
+
+    // Rejects further pushes and wakes every waiter; already queued elements can still be popped.
+    void close() {
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard lock(mutex_);
+        return closed_;
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return size_;
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    PmrQueue<T> queue_;
+    std::size_t capacity_;
+    std::size_t size_{0};
+    std::size_t waiting_consumers_{0};
+    std::size_t waiting_producers_{0};
+    bool closed_{false};
+
+    void wait_not_full(std::unique_lock<std::mutex>& lock) {
+        ++waiting_producers_;
+        not_full_.wait(lock, [this] { return closed_ || size_ < capacity_; });
+        --waiting_producers_;
+    }
+
+    bool wait_not_full_until(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point deadline) {
+        ++waiting_producers_;
+        const bool ready = not_full_.wait_until(lock, deadline, [this] { return closed_ || size_ < capacity_; });
+        --waiting_producers_;
+        return ready && !closed_;
+    }
+
+    void wait_not_empty(std::unique_lock<std::mutex>& lock) {
+        ++waiting_consumers_;
+        not_empty_.wait(lock, [this] { return closed_ || size_ > 0; });
+        --waiting_consumers_;
+    }
+
+    void wait_not_empty_until(std::unique_lock<std::mutex>& lock, std::chrono::steady_clock::time_point deadline) {
+        ++waiting_consumers_;
+        not_empty_.wait_until(lock, deadline, [this] { return closed_ || size_ > 0; });
+        --waiting_consumers_;
+    }
+
+    bool enqueue(std::unique_lock<std::mutex>& lock, T&& value) {
+        if (closed_) {
+            return false;
+        }
+        queue_.push(std::move(value));
+        ++size_;
+        const bool consumer_parked = waiting_consumers_ > 0;
+        lock.unlock();
+        if (consumer_parked) {
+            not_empty_.notify_one();
+        }
+        return true;
+    }
+
+    bool dequeue(T& out) {
+        if (size_ == 0) {
+            return false;
+        }
+        out = std::move(queue_.front());
+        queue_.pop();
+        --size_;
+        if (waiting_producers_ > 0) {
+            not_full_.notify_one();
+        }
+        return true;
+    }
+
+    // Called under the lock; never wakes more consumers than are parked.
+    void wake_consumers(std::size_t published) {
+        for (std::size_t i = 0; i < published && i < waiting_consumers_; ++i) {
+            not_empty_.notify_one();
+        }
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+// Binary buddy allocator over a fixed, aligned buffer. Blocks are powers of two between
+// `min_block` and the whole buffer; allocation and freeing take O(log capacity) steps and
+// buddies are coalesced as soon as both halves are free. Free blocks are linked through their
+// own storage, and one bit per block and order records which blocks are free, so no
+// per-allocation metadata is kept: the block order is recomputed from the size passed to
+// deallocate.
+class BuddyMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit BuddyMemoryResource(std::size_t capacity_bytes, std::size_t min_block = 32,
+                                 std::size_t buffer_alignment = 64)
+        : capacity_(capacity_bytes), min_block_(min_block), buffer_alignment_(buffer_alignment) {
+        if (!std::has_single_bit(capacity_bytes)) {
+            throw std::invalid_argument("Capacity must be a power of two");
+        }
+        if (!std::has_single_bit(min_block) || min_block < sizeof(FreeBlock) || min_block > capacity_bytes) {
+            throw std::invalid_argument("Minimum block must be a power of two that holds the free-list links");
+        }
+        if (!std::has_single_bit(buffer_alignment)) {
+            throw std::invalid_argument("Alignment must be a power of two");
+        }
+        min_shift_ = static_cast<unsigned>(std::countr_zero(min_block));
+        max_order_ = static_cast<unsigned>(std::countr_zero(capacity_bytes)) - min_shift_;
+        if (max_order_ >= 64) {
+            throw std::invalid_argument("Too many block orders");
+        }
+
+        free_lists_.assign(max_order_ + 1, nullptr);
+        bitmap_offsets_.resize(max_order_ + 1);
+        std::size_t words = 0;
+        for (unsigned order = 0; order <= max_order_; ++order) {
+            bitmap_offsets_[order] = words;
+            words += ((capacity_bytes >> (min_shift_ + order)) + 63) / 64;
+        }
+        free_bits_.assign(words, 0);
+
+        buffer_ = static_cast<std::byte*>(::operator new(capacity_bytes, std::align_val_t(buffer_alignment_)));
+        push_free(0, max_order_);
+    }
+
+    BuddyMemoryResource(const BuddyMemoryResource&) = delete;
+    BuddyMemoryResource& operator=(const BuddyMemoryResource&) = delete;
+
+    ~BuddyMemoryResource() override {
+        ::operator delete(buffer_, std::align_val_t(buffer_alignment_));
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    std::byte* data() noexcept { return buffer_; }
+    const std::byte* data() const noexcept { return buffer_; }
+    std::size_t min_block() const noexcept { return min_block_; }
+
+    // Bytes handed out in whole blocks, including rounding up to a power of two.
+    std::size_t used_bytes() const noexcept { return used_bytes_; }
+
+    // Bytes actually requested by callers; the difference to used_bytes() is internal waste.
+    std::size_t requested_bytes() const noexcept { return requested_bytes_; }
+
+    // Size of the largest free block, read from the non-empty order mask in O(1).
+    std::size_t largest_free_gap() const noexcept {
+        return nonempty_orders_ == 0 ? 0 : block_size(63u - static_cast<unsigned>(std::countl_zero(nonempty_orders_)));
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* prev;
+        FreeBlock* next;
+    };
+
+    std::size_t capacity_;
+    std::size_t min_block_;
+    std::size_t buffer_alignment_;
+    unsigned min_shift_{0};
+    unsigned max_order_{0};
+    std::byte* buffer_{nullptr};
+    std::vector<FreeBlock*> free_lists_;
+    std::vector<std::size_t> bitmap_offsets_;
+    std::vector<std::uint64_t> free_bits_;
+    std::uint64_t nonempty_orders_{0};
+    std::size_t used_bytes_{0};
+    std::size_t requested_bytes_{0};
+
+    std::size_t block_size(unsigned order) const noexcept { return min_block_ << order; }
+
+    // Smallest order whose blocks fit `bytes` at `alignment`, or max_order_ + 1 if none does.
+    unsigned order_for(std::size_t bytes, std::size_t alignment) const noexcept {
+        std::size_t size = bytes > alignment ? bytes : alignment;
+        if (size <= min_block_) {
+            return 0;
+        }
+        if (size > capacity_) {
+            return max_order_ + 1;
+        }
+        return static_cast<unsigned>(std::bit_width(size - 1)) - min_shift_;
+    }
+
+    std::size_t bit_index(std::size_t offset, unsigned order) const noexcept {
+        return offset >> (min_shift_ + order);
+    }
+
+    bool is_free(std::size_t offset, unsigned order) const noexcept {
+        const std::size_t bit = bit_index(offset, order);
+        return (free_bits_[bitmap_offsets_[order] + bit / 64] >> (bit % 64)) & 1u;
+    }
+
+    // True if the block, or any block containing it, is currently free (a double free).
+    bool inside_free_block(std::size_t offset, unsigned order) const noexcept {
+        for (unsigned current = order; current <= max_order_; ++current) {
+            if (is_free(offset & ~(block_size(current) - 1), current)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void set_free_bit(std::size_t offset, unsigned order, bool value) noexcept {
+        const std::size_t bit = bit_index(offset, order);
+        std::uint64_t& word = free_bits_[bitmap_offsets_[order] + bit / 64];
+        const std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+    void push_free(std::size_t offset, unsigned order) noexcept {
+        auto* block = ::new (static_cast<void*>(buffer_ + offset)) FreeBlock{nullptr, free_lists_[order]};
+        if (block->next != nullptr) {
+            block->next->prev = block;
+        }
+        free_lists_[order] = block;
+        nonempty_orders_ |= std::uint64_t{1} << order;
+        set_free_bit(offset, order, true);
+    }
+
+    void remove_free(std::size_t offset, unsigned order) noexcept {
+        auto* block = reinterpret_cast<FreeBlock*>(buffer_ + offset);
+        if (block->prev != nullptr) {
+            block->prev->next = block->next;
+        } else {
+            free_lists_[order] = block->next;
+        }
+        if (block->next != nullptr) {
+            block->next->prev = block->prev;
+        }
+        if (free_lists_[order] == nullptr) {
+            nonempty_orders_ &= ~(std::uint64_t{1} << order);
+        }
+        set_free_bit(offset, order, false);
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        const std::size_t required_alignment = alignment == 0 ? alignof(std::max_align_t) : alignment;
+        if (required_alignment > buffer_alignment_) {
+            throw std::bad_alloc();
+        }
+        const unsigned order = order_for(bytes, required_alignment);
+        if (order > max_order_) {
+            throw std::bad_alloc();
+        }
+        const std::uint64_t candidates = nonempty_orders_ & (~std::uint64_t{0} << order);
+        if (candidates == 0) {
+            throw std::bad_alloc();
+        }
+
+        unsigned current = static_cast<unsigned>(std::countr_zero(candidates));
+        const std::size_t offset = static_cast<std::size_t>(reinterpret_cast<std::byte*>(free_lists_[current]) - buffer_);
+        remove_free(offset, current);
+        while (current > order) {
+            --current;
+            push_free(offset + block_size(current), current);
+        }
+        used_bytes_ += block_size(order);
+        requested_bytes_ += bytes;
+        return buffer_ + offset;
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        const auto byte_ptr = static_cast<std::byte*>(ptr);
+        if (byte_ptr < buffer_ || byte_ptr >= buffer_ + capacity_) {
+            throw std::logic_error("Pointer does not belong to this resource");
+        }
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        unsigned order = order_for(bytes, alignment == 0 ? alignof(std::max_align_t) : alignment);
+        std::size_t offset = static_cast<std::size_t>(byte_ptr - buffer_);
+        if (order > max_order_ || offset % block_size(order) != 0 || inside_free_block(offset, order)) {
+            throw std::logic_error("Attempt to deallocate unmanaged block");
+        }
+        used_bytes_ -= block_size(order);
+        requested_bytes_ -= bytes;
+
+        while (order < max_order_) {
+            const std::size_t buddy = offset ^ block_size(order);
+            if (!is_free(buddy, order)) {
+                break;
+            }
+            remove_free(buddy, order);
+            offset = offset < buddy ? offset : buddy;
+            ++order;
+        }
+        push_free(offset, order);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
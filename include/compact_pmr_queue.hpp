@@ -0,0 +1,228 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+// Resource that manages one contiguous buffer and exposes its start and size.
+template <class Resource>
+concept BoundedBufferResource = std::derived_from<Resource, std::pmr::memory_resource> && requires(Resource& resource) {
+    { resource.data() } -> std::convertible_to<std::byte*>;
+    { resource.capacity() } -> std::convertible_to<std::size_t>;
+};
+
+// FIFO queue for resources with a single buffer below 4 GiB. Nodes are linked by 32-bit
+// offsets from the buffer start instead of pointers, so PmrQueue's 8-byte link and its padding
+// shrink to 4 bytes: a node of PmrQueue<int> takes 16 bytes, here it takes 8. Head, tail and
+// links are all offsets, so the element chain does not depend on where the buffer is mapped.
+// Elements are built by uses-allocator construction from the same resource.
+template <class T>
+class CompactPmrQueue {
+public:
+    using offset_type = std::uint32_t;
+    static constexpr offset_type null_offset = UINT32_MAX;
+
+private:
+    struct Node {
+        template <class... Args>
+        explicit Node(const std::pmr::polymorphic_allocator<>& alloc, Args&&... args)
+            : value(std::make_obj_using_allocator<T>(alloc, std::forward<Args>(args)...)) {}
+        T value;
+        offset_type next{null_offset};
+    };
+
+    using allocator_type = std::pmr::polymorphic_allocator<Node>;
+
+public:
+    using value_type = T;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        iterator(std::byte* base, offset_type node) : base_(base), node_(node) {}
+
+        reference operator*() const { return node_at(base_, node_)->value; }
+        pointer operator->() const { return std::addressof(node_at(base_, node_)->value); }
+
+        iterator& operator++() {
+            if (node_ != null_offset) {
+                node_ = node_at(base_, node_)->next;
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator copy(*this);
+            ++(*this);
+            return copy;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            return lhs.node_ == rhs.node_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        std::byte* base_{nullptr};
+        offset_type node_{null_offset};
+    };
+
+    template <BoundedBufferResource Resource>
+    explicit CompactPmrQueue(Resource& resource) : allocator_(&resource), base_(resource.data()) {
+        // The last offset is reserved as the null link.
+        if (resource.capacity() > null_offset) {
+            throw std::invalid_argument("Resource buffer is too large for 32-bit offsets");
+        }
+    }
+
+    CompactPmrQueue(const CompactPmrQueue&) = delete;
+    CompactPmrQueue& operator=(const CompactPmrQueue&) = delete;
+
+    CompactPmrQueue(CompactPmrQueue&& other) noexcept
+        : allocator_(other.allocator_),
+          base_(other.base_),
+          head_(std::exchange(other.head_, null_offset)),
+          tail_(std::exchange(other.tail_, null_offset)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    CompactPmrQueue& operator=(CompactPmrQueue&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        allocator_ = other.allocator_;
+        base_ = other.base_;
+        head_ = std::exchange(other.head_, null_offset);
+        tail_ = std::exchange(other.tail_, null_offset);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    ~CompactPmrQueue() {
+        clear();
+    }
+
+    template <class... Args>
+    void emplace(Args&&... args) {
+        Node* new_node = allocator_.allocate(1);
+        offset_type offset = null_offset;
+        try {
+            offset = offset_of(new_node);
+            std::allocator_traits<allocator_type>::construct(
+                allocator_, new_node, std::pmr::polymorphic_allocator<>(allocator_), std::forward<Args>(args)...);
+        } catch (...) {
+            allocator_.deallocate(new_node, 1);
+            throw;
+        }
+
+        if (tail_ == null_offset) {
+            head_ = tail_ = offset;
+        } else {
+            node_at(base_, tail_)->next = offset;
+            tail_ = offset;
+        }
+        ++size_;
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    void pop() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+
+        Node* old_head = node_at(base_, head_);
+        head_ = old_head->next;
+        if (head_ == null_offset) {
+            tail_ = null_offset;
+        }
+        std::allocator_traits<allocator_type>::destroy(allocator_, old_head);
+        allocator_.deallocate(old_head, 1);
+        --size_;
+    }
+
+    T& front() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        return node_at(base_, head_)->value;
+    }
+
+    const T& front() const {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        return node_at(base_, head_)->value;
+    }
+
+    void clear() noexcept {
+        while (!empty()) {
+            pop();
+        }
+    }
+
+    bool empty() const noexcept { return head_ == null_offset; }
+    std::size_t size() const noexcept { return size_; }
+    std::pmr::memory_resource* resource() const noexcept { return allocator_.resource(); }
+
+    static constexpr std::size_t node_size() noexcept { return sizeof(Node); }
+
+    // Head, tail and size; with the buffer contents this fully describes the queue, wherever
+    // the buffer is mapped.
+    struct Image {
+        offset_type head{null_offset};
+        offset_type tail{null_offset};
+        std::uint64_t size{0};
+    };
+
+    Image image() const noexcept { return Image{head_, tail_, size_}; }
+
+    // Adopts the nodes of `image` after the buffer was filled, e.g. from a snapshot. No links
+    // need fixing up since they are offsets.
+    void restore_image(const Image& image) {
+        if (!empty()) {
+            throw std::logic_error("Image can only be restored into an empty queue");
+        }
+        head_ = image.head;
+        tail_ = image.tail;
+        size_ = static_cast<std::size_t>(image.size);
+    }
+
+    iterator begin() noexcept { return iterator(base_, head_); }
+    iterator end() noexcept { return iterator(base_, null_offset); }
+
+private:
+    allocator_type allocator_;
+    std::byte* base_;
+    offset_type head_{null_offset};
+    offset_type tail_{null_offset};
+    std::size_t size_{0};
+
+    static Node* node_at(std::byte* base, offset_type offset) noexcept {
+        return reinterpret_cast<Node*>(base + offset);
+    }
+
+    offset_type offset_of(const Node* node) const {
+        const auto bytes = reinterpret_cast<const std::byte*>(node);
+        // Catches resources that satisfy the concept but hand out memory outside data().
+        if (bytes < base_ || static_cast<std::size_t>(bytes - base_) >= null_offset) {
+            throw std::logic_error("Node lies outside the resource buffer");
+        }
+        return static_cast<offset_type>(bytes - base_);
+    }
+};
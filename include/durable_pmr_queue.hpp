@@ -0,0 +1,548 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+#include "queue_serializer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+struct DurableQueueOptions {
+    std::filesystem::path directory;
+    // A new log segment is started once the active one grows past this size.
+    std::size_t segment_bytes{std::size_t{1} << 24};
+    // Pops between automatic checkpoints; 0 leaves checkpointing to the caller.
+    std::size_t checkpoint_interval{4096};
+    // fdatasync() every group commit. Disabling it keeps the log format but not durability.
+    bool sync{true};
+};
+
+struct DurableQueueStats {
+    std::uint64_t appends{0};
+    std::uint64_t group_commits{0};
+    std::uint64_t bytes_written{0};
+    std::uint64_t checkpoints{0};
+    std::uint64_t segments_removed{0};
+    std::uint64_t replayed{0};
+    // Automatic checkpoints that threw; each is retried after the next interval of pops.
+    std::uint64_t checkpoint_failures{0};
+};
+
+namespace durable_queue_detail {
+
+inline std::uint32_t checksum(std::span<const std::byte> bytes, std::uint32_t hash = 2166136261u) noexcept {
+    for (const std::byte byte : bytes) {
+        hash = (hash ^ static_cast<std::uint32_t>(byte)) * 16777619u;
+    }
+    return hash;
+}
+
+// Append-only file descriptor with explicit syncs.
+class LogFile {
+public:
+    LogFile() = default;
+
+    explicit LogFile(const std::filesystem::path& path) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "open " + path.string());
+        }
+    }
+
+    LogFile(LogFile&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+    LogFile& operator=(LogFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    ~LogFile() {
+        close();
+    }
+
+    void write(std::span<const std::byte> bytes) {
+        while (!bytes.empty()) {
+            const ssize_t written = ::write(fd_, bytes.data(), bytes.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write-ahead log write");
+            }
+            bytes = bytes.subspan(static_cast<std::size_t>(written));
+        }
+    }
+
+    void sync() {
+        if (::fdatasync(fd_) != 0) {
+            throw std::system_error(errno, std::generic_category(), "write-ahead log fdatasync");
+        }
+    }
+
+private:
+    int fd_{-1};
+
+    void close() noexcept {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
+
+// Makes newly created or renamed entries of `directory` survive a crash.
+inline void sync_directory(const std::filesystem::path& directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "open " + directory.string());
+    }
+    const int result = ::fsync(fd);
+    const int error = errno;
+    ::close(fd);
+    if (result != 0) {
+        throw std::system_error(error, std::generic_category(), "fsync " + directory.string());
+    }
+}
+
+}  // namespace durable_queue_detail
+
+// FIFO queue whose pushes are appended to a write-ahead log before they become visible.
+//
+// Each push is serialized with `Serializer` into a checksummed record. Concurrent producers
+// share fsyncs through group commit: the first producer that finds no write in flight becomes
+// the leader, writes every record buffered so far with one write() and one fdatasync(), and
+// wakes the followers whose records it covered; records appended meanwhile form the next
+// group. push() returns once its record is durable, and pops only see durable elements.
+//
+// Pops are not logged. checkpoint() persists the sequence number of the last popped element,
+// and log segments whose records are all at or below it are deleted. On construction the
+// directory is replayed: each segment is read with one sequential read, records past the
+// checkpoint are rebuilt into `resource`, and a torn record at the end of the log is cut off.
+// Elements popped after the last checkpoint are therefore delivered again after a restart.
+// A failing automatic checkpoint never costs the popped element: it is counted in
+// stats().checkpoint_failures, and an explicit checkpoint() call reports the error.
+template <class T, class Serializer = QueueSerializer<T>>
+class DurablePmrQueue {
+public:
+    using value_type = T;
+
+    DurablePmrQueue(std::pmr::memory_resource* resource, DurableQueueOptions options)
+        : items_(resource), options_(std::move(options)) {
+        std::filesystem::create_directories(options_.directory);
+        consumed_seq_ = read_checkpoint();
+        checkpointed_seq_ = consumed_seq_;
+        auto_checkpoint_seq_ = consumed_seq_;
+        replay();
+        durable_seq_ = consumed_seq_ + items_.size();
+        next_seq_ = durable_seq_ + 1;
+        stats_.segments_removed += remove_consumed_segments();
+        open_segment(next_seq_);
+    }
+
+    DurablePmrQueue(const DurablePmrQueue&) = delete;
+    DurablePmrQueue& operator=(const DurablePmrQueue&) = delete;
+
+    // Returns the element's sequence number once its record is on stable storage.
+    std::uint64_t push(const T& value) {
+        std::vector<std::byte> payload;
+        Serializer::write(value, payload);
+        std::unique_lock lock(mutex_);
+        reserve_pending(payload.size(), 1);
+        items_.push(value);
+        const std::uint64_t seq = append_record(payload);
+        wait_durable(lock, seq);
+        return seq;
+    }
+
+    std::uint64_t push(T&& value) {
+        std::vector<std::byte> payload;
+        Serializer::write(value, payload);
+        std::unique_lock lock(mutex_);
+        reserve_pending(payload.size(), 1);
+        items_.push(std::move(value));
+        const std::uint64_t seq = append_record(payload);
+        wait_durable(lock, seq);
+        return seq;
+    }
+
+    // Appends [first, last) as consecutive records and waits for them once. Returns the
+    // sequence number of the last element, or the durable sequence if the range is empty.
+    // The elements are copied aside first, so a throwing copy queues and logs none of them.
+    template <class ForwardIt>
+    std::uint64_t push_bulk(ForwardIt first, ForwardIt last) {
+        std::vector<std::byte> payloads;
+        std::vector<std::size_t> ends;
+        for (ForwardIt it = first; it != last; ++it) {
+            Serializer::write(*it, payloads);
+            ends.push_back(payloads.size());
+        }
+        std::unique_lock lock(mutex_);
+        reserve_pending(payloads.size(), ends.size());
+        PmrQueue<T> staged(items_.resource());
+        for (ForwardIt it = first; it != last; ++it) {
+            staged.push(*it);
+        }
+        items_.splice(staged);
+        std::uint64_t seq = durable_seq_;
+        std::size_t begin = 0;
+        for (const std::size_t end : ends) {
+            seq = append_record(std::span<const std::byte>(payloads).subspan(begin, end - begin));
+            begin = end;
+        }
+        wait_durable(lock, seq);
+        return seq;
+    }
+
+    // Moves the oldest durable element into `out`; returns false if there is none.
+    bool try_pop(T& out) {
+        std::unique_lock lock(mutex_);
+        return dequeue(lock, out);
+    }
+
+    template <class Rep, class Period>
+    bool pop_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock lock(mutex_);
+        flushed_.wait_for(lock, timeout, [this] { return visible() > 0; });
+        return dequeue(lock, out);
+    }
+
+    // Persists the consumer offset and deletes log segments that are fully consumed.
+    void checkpoint() {
+        std::uint64_t consumed = 0;
+        {
+            std::lock_guard lock(mutex_);
+            consumed = consumed_seq_;
+        }
+        std::lock_guard log_lock(log_mutex_);
+        if (consumed <= checkpointed_seq_) {
+            return;
+        }
+        write_checkpoint(consumed);
+        checkpointed_seq_ = consumed;
+        const std::size_t removed = remove_consumed_segments();
+        std::lock_guard lock(mutex_);
+        ++stats_.checkpoints;
+        stats_.segments_removed += removed;
+    }
+
+    // Durable elements not yet popped.
+    std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return visible();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    std::uint64_t durable_sequence() const {
+        std::lock_guard lock(mutex_);
+        return durable_seq_;
+    }
+
+    std::uint64_t consumed_sequence() const {
+        std::lock_guard lock(mutex_);
+        return consumed_seq_;
+    }
+
+    std::size_t segment_count() const {
+        std::lock_guard log_lock(log_mutex_);
+        return segments_.size();
+    }
+
+    DurableQueueStats stats() const {
+        std::lock_guard lock(mutex_);
+        return stats_;
+    }
+
+    std::pmr::memory_resource* resource() const noexcept { return items_.resource(); }
+
+private:
+    static constexpr std::size_t kRecordHeaderBytes = 16;
+    static constexpr std::uint64_t kCheckpointMagic = 0x504d52'43484b'3031ull;
+
+    struct Segment {
+        std::uint64_t first_seq;
+        std::uint64_t last_seq;
+        std::filesystem::path path;
+    };
+
+    // Guards the queue, the pending group and the counters.
+    mutable std::mutex mutex_;
+    std::condition_variable flushed_;
+    PmrQueue<T> items_;
+    std::vector<std::byte> pending_;
+    std::vector<std::byte> spare_;
+    std::uint64_t next_seq_{1};
+    std::uint64_t durable_seq_{0};
+    std::uint64_t consumed_seq_{0};
+    // Consumer offset at the last automatic checkpoint.
+    std::uint64_t auto_checkpoint_seq_{0};
+    bool flushing_{false};
+    std::exception_ptr failure_;
+    DurableQueueStats stats_{};
+
+    // Guards the files; held by the commit leader while it writes.
+    mutable std::mutex log_mutex_;
+    durable_queue_detail::LogFile log_;
+    std::deque<Segment> segments_;
+    std::size_t active_bytes_{0};
+    std::uint64_t checkpointed_seq_{0};
+
+    DurableQueueOptions options_;
+
+    std::size_t visible() const noexcept {
+        return static_cast<std::size_t>(durable_seq_ - consumed_seq_);
+    }
+
+    std::filesystem::path checkpoint_path() const {
+        return options_.directory / "checkpoint";
+    }
+
+    std::filesystem::path segment_path(std::uint64_t first_seq) const {
+        std::string digits = std::to_string(first_seq);
+        digits.insert(0, 20 - digits.size(), '0');
+        return options_.directory / ("wal-" + digits + ".log");
+    }
+
+    // Grows the pending group for `records` records before anything is queued, so the
+    // append_record() calls that follow cannot fail and leave a gap in the sequence.
+    void reserve_pending(std::size_t payload_bytes, std::size_t records) {
+        pending_.reserve(pending_.size() + payload_bytes + records * kRecordHeaderBytes);
+    }
+
+    // Called under mutex_ after the element has been queued into reserved pending_ space.
+    std::uint64_t append_record(std::span<const std::byte> payload) noexcept {
+        const std::uint64_t seq = next_seq_++;
+        std::byte header[kRecordHeaderBytes];
+        const auto length = static_cast<std::uint32_t>(payload.size());
+        std::memcpy(header + 8, &seq, sizeof(seq));
+        const std::uint32_t sum = durable_queue_detail::checksum(
+            payload, durable_queue_detail::checksum(std::span<const std::byte>(header + 8, sizeof(seq))));
+        std::memcpy(header, &length, sizeof(length));
+        std::memcpy(header + 4, &sum, sizeof(sum));
+        pending_.insert(pending_.end(), std::begin(header), std::end(header));
+        pending_.insert(pending_.end(), payload.begin(), payload.end());
+        ++stats_.appends;
+        return seq;
+    }
+
+    void wait_durable(std::unique_lock<std::mutex>& lock, std::uint64_t seq) {
+        while (durable_seq_ < seq) {
+            if (failure_) {
+                std::rethrow_exception(failure_);
+            }
+            if (flushing_) {
+                flushed_.wait(lock);
+            } else {
+                commit_group(lock);
+            }
+        }
+    }
+
+    // Leader path: writes everything buffered so far with the queue unlocked.
+    void commit_group(std::unique_lock<std::mutex>& lock) {
+        flushing_ = true;
+        std::vector<std::byte> batch = std::exchange(pending_, std::move(spare_));
+        pending_.clear();
+        const std::uint64_t last_seq = next_seq_ - 1;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            std::lock_guard log_lock(log_mutex_);
+            log_.write(batch);
+            if (options_.sync) {
+                log_.sync();
+            }
+            active_bytes_ += batch.size();
+            segments_.back().last_seq = last_seq;
+            if (active_bytes_ >= options_.segment_bytes) {
+                open_segment(last_seq + 1);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        flushing_ = false;
+        if (error) {
+            failure_ = error;
+        } else {
+            durable_seq_ = last_seq;
+            ++stats_.group_commits;
+            stats_.bytes_written += batch.size();
+            batch.clear();
+            spare_ = std::move(batch);
+        }
+        flushed_.notify_all();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    bool dequeue(std::unique_lock<std::mutex>& lock, T& out) {
+        if (visible() == 0) {
+            return false;
+        }
+        out = std::move(items_.front());
+        items_.pop();
+        ++consumed_seq_;
+        const bool due = options_.checkpoint_interval != 0 &&
+                         consumed_seq_ - auto_checkpoint_seq_ >= options_.checkpoint_interval;
+        if (due) {
+            auto_checkpoint_seq_ = consumed_seq_;
+            lock.unlock();
+            try {
+                checkpoint();
+            } catch (...) {
+                lock.lock();
+                ++stats_.checkpoint_failures;
+            }
+        }
+        return true;
+    }
+
+    // Called with log_mutex_ held or from the constructor.
+    void open_segment(std::uint64_t first_seq) {
+        if (!segments_.empty() && segments_.back().first_seq == first_seq) {
+            segments_.pop_back();
+        }
+        log_ = durable_queue_detail::LogFile(segment_path(first_seq));
+        durable_queue_detail::sync_directory(options_.directory);
+        segments_.push_back(Segment{first_seq, first_seq - 1, segment_path(first_seq)});
+        active_bytes_ = 0;
+    }
+
+    // Keeps the active segment even when it is fully consumed. Returns how many were deleted.
+    // Stops at the first segment that cannot be removed, so no gap opens in front of it; the
+    // next checkpoint tries again.
+    std::size_t remove_consumed_segments() {
+        std::size_t removed = 0;
+        while (segments_.size() > 1 && segments_.front().last_seq <= checkpointed_seq_) {
+            std::error_code error;
+            std::filesystem::remove(segments_.front().path, error);
+            if (error) {
+                break;
+            }
+            segments_.pop_front();
+            ++removed;
+        }
+        return removed;
+    }
+
+    std::uint64_t read_checkpoint() const {
+        std::ifstream in(checkpoint_path(), std::ios::binary);
+        if (!in) {
+            return 0;
+        }
+        std::uint64_t fields[2] = {};
+        in.read(reinterpret_cast<char*>(fields), sizeof(fields));
+        if (!in || fields[0] != kCheckpointMagic) {
+            throw std::runtime_error("Corrupted queue checkpoint " + checkpoint_path().string());
+        }
+        return fields[1];
+    }
+
+    // Written to a temporary file and renamed, so a crash leaves either checkpoint intact.
+    void write_checkpoint(std::uint64_t consumed) const {
+        const std::filesystem::path temporary = options_.directory / "checkpoint.tmp";
+        {
+            const std::uint64_t fields[2] = {kCheckpointMagic, consumed};
+            durable_queue_detail::LogFile file(temporary);
+            file.write(std::as_bytes(std::span(fields)));
+            file.sync();
+        }
+        std::filesystem::rename(temporary, checkpoint_path());
+        durable_queue_detail::sync_directory(options_.directory);
+    }
+
+    void replay() {
+        for (const auto& entry : std::filesystem::directory_iterator(options_.directory)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() == 28 && name.starts_with("wal-") && name.ends_with(".log")) {
+                const std::uint64_t first_seq = std::stoull(name.substr(4, 20));
+                segments_.push_back(Segment{first_seq, first_seq - 1, entry.path()});
+            }
+        }
+        std::sort(segments_.begin(), segments_.end(),
+                  [](const Segment& lhs, const Segment& rhs) { return lhs.first_seq < rhs.first_seq; });
+
+        const std::pmr::polymorphic_allocator<> alloc(items_.resource());
+        std::uint64_t expected = segments_.empty() ? consumed_seq_ + 1 : segments_.front().first_seq;
+        if (expected > consumed_seq_ + 1) {
+            throw std::runtime_error("Write-ahead log starts after the checkpoint");
+        }
+        for (std::size_t index = 0; index < segments_.size(); ++index) {
+            Segment& segment = segments_[index];
+            if (segment.first_seq != expected) {
+                throw std::runtime_error("Write-ahead log has a gap before " + segment.path.string());
+            }
+            const std::size_t good = replay_segment(segment, alloc, expected);
+            if (good < std::filesystem::file_size(segment.path)) {
+                if (index + 1 != segments_.size()) {
+                    throw std::runtime_error("Corrupted write-ahead log segment " + segment.path.string());
+                }
+                std::filesystem::resize_file(segment.path, good);
+            }
+        }
+    }
+
+    // Rebuilds the records of one segment past the checkpoint; returns the valid prefix length.
+    std::size_t replay_segment(Segment& segment, const std::pmr::polymorphic_allocator<>& alloc,
+                               std::uint64_t& expected) {
+        std::vector<std::byte> bytes(static_cast<std::size_t>(std::filesystem::file_size(segment.path)));
+        std::ifstream in(segment.path, std::ios::binary);
+        in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!in) {
+            throw std::runtime_error("Cannot read write-ahead log segment " + segment.path.string());
+        }
+
+        std::size_t offset = 0;
+        while (bytes.size() - offset >= kRecordHeaderBytes) {
+            std::uint32_t length = 0;
+            std::uint32_t sum = 0;
+            std::uint64_t seq = 0;
+            std::memcpy(&length, bytes.data() + offset, sizeof(length));
+            std::memcpy(&sum, bytes.data() + offset + 4, sizeof(sum));
+            std::memcpy(&seq, bytes.data() + offset + 8, sizeof(seq));
+            if (seq != expected || bytes.size() - offset - kRecordHeaderBytes < length) {
+                break;
+            }
+            const std::span<const std::byte> record(bytes.data() + offset + 8, sizeof(seq) + length);
+            if (durable_queue_detail::checksum(record) != sum) {
+                break;
+            }
+            if (seq > consumed_seq_) {
+                std::span<const std::byte> payload = record.subspan(sizeof(seq));
+                items_.push(Serializer::read(payload, alloc));
+                ++stats_.replayed;
+            }
+            segment.last_seq = seq;
+            ++expected;
+            offset += kRecordHeaderBytes + length;
+        }
+        return offset;
+    }
+};
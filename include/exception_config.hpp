@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdlib>
+#include <utility>
+
+// Lets the queue and resource headers build with -fno-exceptions. Where exceptions are off,
+// error paths that would throw terminate instead, and the try_* APIs are the way to observe
+// failures.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define PMR_QUEUE_HAS_EXCEPTIONS 1
+#define PMR_QUEUE_TRY try
+#define PMR_QUEUE_CATCH(declaration) catch (declaration)
+#define PMR_QUEUE_RETHROW throw
+#else
+#define PMR_QUEUE_HAS_EXCEPTIONS 0
+#define PMR_QUEUE_TRY if (true)
+#define PMR_QUEUE_CATCH(declaration) else
+#define PMR_QUEUE_RETHROW static_cast<void>(0)
+#endif
+
+template <class Exception>
+[[noreturn]] inline void pmr_queue_throw(Exception&& exception) {
+#if PMR_QUEUE_HAS_EXCEPTIONS
+    throw std::forward<Exception>(exception);
+#else
+    static_cast<void>(exception);
+    std::abort();
+#endif
+}
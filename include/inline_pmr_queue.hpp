@@ -0,0 +1,184 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Queue that keeps its first N elements in a ring inside the object and spills to a
+// PmrQueue on the polymorphic allocator only beyond that. Every inline element is older
+// than every spilled one, so FIFO order holds across the boundary. Inline elements are built
+// by uses-allocator construction with the same resource as spilled ones.
+template <class T, std::size_t N>
+class InlinePmrQueue {
+    static_assert(N > 0, "Inline capacity must be greater than zero");
+
+    using spill_queue = PmrQueue<T>;
+
+public:
+    using value_type = T;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        iterator(InlinePmrQueue* owner, std::size_t index, typename spill_queue::iterator spill)
+            : owner_(owner), index_(index), spill_(spill) {}
+
+        reference operator*() const {
+            return index_ < owner_->inline_size_ ? *owner_->inline_at(index_) : *spill_;
+        }
+
+        pointer operator->() const { return std::addressof(**this); }
+
+        iterator& operator++() {
+            if (index_ < owner_->inline_size_) {
+                ++index_;
+            } else {
+                ++spill_;
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator copy(*this);
+            ++(*this);
+            return copy;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            return lhs.index_ == rhs.index_ && lhs.spill_ == rhs.spill_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        InlinePmrQueue* owner_{nullptr};
+        std::size_t index_{0};
+        typename spill_queue::iterator spill_{};
+    };
+
+    explicit InlinePmrQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : spill_(resource) {}
+
+    InlinePmrQueue(const InlinePmrQueue&) = delete;
+    InlinePmrQueue& operator=(const InlinePmrQueue&) = delete;
+
+    InlinePmrQueue(InlinePmrQueue&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : spill_(std::move(other.spill_)) {
+        take_inline(other);
+    }
+
+    InlinePmrQueue& operator=(InlinePmrQueue&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this == &other) {
+            return *this;
+        }
+        destroy_inline();
+        spill_ = std::move(other.spill_);
+        take_inline(other);
+        return *this;
+    }
+
+    ~InlinePmrQueue() {
+        destroy_inline();
+    }
+
+    static constexpr std::size_t inline_capacity() noexcept { return N; }
+
+    template <class... Args>
+    void emplace(Args&&... args) {
+        if (inline_size_ < N && spill_.empty()) {
+            std::uninitialized_construct_using_allocator(slot((inline_head_ + inline_size_) % N),
+                                                         std::pmr::polymorphic_allocator<>(spill_.resource()),
+                                                         std::forward<Args>(args)...);
+            ++inline_size_;
+        } else {
+            spill_.emplace(std::forward<Args>(args)...);
+            ++spilled_size_;
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    void pop() {
+        if (inline_size_ > 0) {
+            std::destroy_at(slot(inline_head_));
+            inline_head_ = (inline_head_ + 1) % N;
+            --inline_size_;
+            return;
+        }
+        spill_.pop();
+        --spilled_size_;
+    }
+
+    T& front() {
+        return inline_size_ > 0 ? *slot(inline_head_) : spill_.front();
+    }
+
+    const T& front() const {
+        return inline_size_ > 0 ? *slot(inline_head_) : spill_.front();
+    }
+
+    bool empty() const noexcept { return inline_size_ == 0 && spilled_size_ == 0; }
+    std::size_t size() const noexcept { return inline_size_ + spilled_size_; }
+
+    // Number of elements currently stored through the memory resource.
+    std::size_t spilled_size() const noexcept { return spilled_size_; }
+
+    iterator begin() noexcept { return iterator(this, 0, spill_.begin()); }
+    iterator end() noexcept { return iterator(this, inline_size_, spill_.end()); }
+
+private:
+    alignas(T) std::byte storage_[N * sizeof(T)];
+    std::size_t inline_head_{0};
+    std::size_t inline_size_{0};
+    std::size_t spilled_size_{0};
+    spill_queue spill_;
+
+    T* slot(std::size_t index) noexcept {
+        return std::launder(reinterpret_cast<T*>(storage_ + index * sizeof(T)));
+    }
+
+    const T* slot(std::size_t index) const noexcept {
+        return std::launder(reinterpret_cast<const T*>(storage_ + index * sizeof(T)));
+    }
+
+    T* inline_at(std::size_t position) noexcept {
+        return slot((inline_head_ + position) % N);
+    }
+
+    void take_inline(InlinePmrQueue& other) {
+        for (std::size_t i = 0; i < other.inline_size_; ++i) {
+            std::uninitialized_construct_using_allocator(slot(i), std::pmr::polymorphic_allocator<>(spill_.resource()),
+                                                         std::move(*other.inline_at(i)));
+        }
+        inline_head_ = 0;
+        inline_size_ = other.inline_size_;
+        spilled_size_ = other.spilled_size_;
+        other.destroy_inline();
+        other.spilled_size_ = 0;
+    }
+
+    void destroy_inline() noexcept {
+        while (inline_size_ > 0) {
+            std::destroy_at(slot(inline_head_));
+            inline_head_ = (inline_head_ + 1) % N;
+            --inline_size_;
+        }
+        inline_head_ = 0;
+    }
+};
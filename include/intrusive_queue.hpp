@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+// Link embedded into every element that can be placed into an IntrusiveQueue.
+template <class T>
+struct IntrusiveQueueHook {
+    T* next{nullptr};
+};
+
+// FIFO queue over caller-owned elements linked through an embedded hook.
+// push/pop never allocate and never copy or move the payload.
+template <class T, IntrusiveQueueHook<T> T::*Hook = &T::queue_hook>
+class IntrusiveQueue {
+public:
+    using value_type = T;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+        explicit iterator(T* element) : element_(element) {}
+
+        reference operator*() const { return *element_; }
+        pointer operator->() const { return element_; }
+
+        iterator& operator++() {
+            if (element_ != nullptr) {
+                element_ = next_of(*element_);
+            }
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator copy(*this);
+            ++(*this);
+            return copy;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) {
+            return lhs.element_ == rhs.element_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        T* element_{nullptr};
+    };
+
+    IntrusiveQueue() = default;
+
+    IntrusiveQueue(const IntrusiveQueue&) = delete;
+    IntrusiveQueue& operator=(const IntrusiveQueue&) = delete;
+
+    IntrusiveQueue(IntrusiveQueue&& other) noexcept
+        : head_(other.head_), tail_(other.tail_), size_(other.size_) {
+        other.head_ = nullptr;
+        other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
+    IntrusiveQueue& operator=(IntrusiveQueue&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        head_ = other.head_;
+        tail_ = other.tail_;
+        size_ = other.size_;
+        other.head_ = nullptr;
+        other.tail_ = nullptr;
+        other.size_ = 0;
+        return *this;
+    }
+
+    // Elements are owned by the caller, so destruction only unlinks them.
+    ~IntrusiveQueue() {
+        clear();
+    }
+
+    void push(T& element) noexcept {
+        (element.*Hook).next = nullptr;
+        if (tail_ == nullptr) {
+            head_ = tail_ = std::addressof(element);
+        } else {
+            (tail_->*Hook).next = std::addressof(element);
+            tail_ = std::addressof(element);
+        }
+        ++size_;
+    }
+
+    void pop() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+
+        T* old_head = head_;
+        head_ = next_of(*head_);
+        if (head_ == nullptr) {
+            tail_ = nullptr;
+        }
+        (old_head->*Hook).next = nullptr;
+        --size_;
+    }
+
+    T& front() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        return *head_;
+    }
+
+    const T& front() const {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        return *head_;
+    }
+
+    // Moves every element of `other` to the back of this queue in O(1).
+    void splice(IntrusiveQueue& other) noexcept {
+        if (this == &other || other.empty()) {
+            return;
+        }
+        if (tail_ == nullptr) {
+            head_ = other.head_;
+        } else {
+            (tail_->*Hook).next = other.head_;
+        }
+        tail_ = other.tail_;
+        size_ += other.size_;
+        other.head_ = nullptr;
+        other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
+    void clear() noexcept {
+        while (head_ != nullptr) {
+            T* next = next_of(*head_);
+            (head_->*Hook).next = nullptr;
+            head_ = next;
+        }
+        tail_ = nullptr;
+        size_ = 0;
+    }
+
+    bool empty() const noexcept { return head_ == nullptr; }
+    std::size_t size() const noexcept { return size_; }
+
+    iterator begin() noexcept { return iterator(head_); }
+    iterator end() noexcept { return iterator(nullptr); }
+
+private:
+    T* head_{nullptr};
+    T* tail_{nullptr};
+    std::size_t size_{0};
+
+    static T* next_of(const T& element) noexcept {
+        return (element.*Hook).next;
+    }
+};
@@ -1,73 +1,386 @@
 #pragma once
 
+#include "exception_config.hpp"
+
 #include <cstddef>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory_resource>
+#include <mutex>
 #include <new>
+#include <span>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
-class CustomBlockMemoryResource : public std::pmr::memory_resource {
+enum class MemoryPressure : std::uint8_t { normal, low, high, critical };
+
+// Thresholds for BasicBlockMemoryResource::pressure(). A used-bytes level is reached when
+// used bytes climb to the threshold; a gap level is reached when the largest free gap shrinks
+// to the threshold. Zero disables a threshold. The largest gap costs a scan of the block
+// table, so it is re-measured only every `gap_check_interval` allocate/deallocate calls
+// and after a failed allocation.
+struct MemoryWatermarks {
+    std::size_t used_low{0};
+    std::size_t used_high{0};
+    std::size_t used_critical{0};
+    std::size_t gap_low{0};
+    std::size_t gap_high{0};
+    std::size_t gap_critical{0};
+    std::size_t gap_check_interval{64};
+};
+
+namespace block_placement {
+
+struct Block {
+    std::size_t offset;
+    std::size_t size;
+};
+
+// Result of a placement search: `offset` of the new block and the `index` in the sorted
+// block table it is inserted before. `offset == npos` means no gap fits.
+struct Placement {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t offset{npos};
+    std::size_t index{0};
+
+    bool found() const noexcept { return offset != npos; }
+};
+
+inline std::size_t align_offset(std::size_t offset, std::size_t alignment) {
+    if (alignment == 0) {
+        return offset;
+    }
+    const std::size_t remainder = offset % alignment;
+    return remainder == 0 ? offset : offset + (alignment - remainder);
+}
+
+inline std::size_t gap_begin(std::span<const Block> blocks, std::size_t index) {
+    return index == 0 ? 0 : blocks[index - 1].offset + blocks[index - 1].size;
+}
+
+inline std::size_t gap_end(std::span<const Block> blocks, std::size_t index, std::size_t capacity) {
+    return index == blocks.size() ? capacity : blocks[index].offset;
+}
+
+// Takes the first gap from offset 0 that fits.
+struct FirstFit {
+    Placement find(std::span<const Block> blocks, std::size_t capacity, std::size_t bytes,
+                   std::size_t alignment) const noexcept {
+        for (std::size_t index = 0; index <= blocks.size(); ++index) {
+            const std::size_t aligned_offset = align_offset(gap_begin(blocks, index), alignment);
+            if (aligned_offset + bytes <= gap_end(blocks, index, capacity)) {
+                return Placement{aligned_offset, index};
+            }
+        }
+        return Placement{};
+    }
+
+    void on_commit(std::size_t, std::size_t) noexcept {}
+};
+
+// Resumes the search at the gap where the previous allocation ended and wraps around once.
+struct NextFit {
+    std::size_t rover{0};
+
+    Placement find(std::span<const Block> blocks, std::size_t capacity, std::size_t bytes,
+                   std::size_t alignment) const noexcept {
+        const auto start = std::lower_bound(blocks.begin(), blocks.end(), rover,
+                                            [](const Block& lhs, std::size_t rhs) { return lhs.offset < rhs; });
+        const std::size_t first = static_cast<std::size_t>(start - blocks.begin());
+        const std::size_t gaps = blocks.size() + 1;
+        for (std::size_t step = 0; step < gaps; ++step) {
+            const std::size_t index = (first + step) % gaps;
+            const std::size_t aligned_offset = align_offset(gap_begin(blocks, index), alignment);
+            if (aligned_offset + bytes <= gap_end(blocks, index, capacity)) {
+                return Placement{aligned_offset, index};
+            }
+        }
+        return Placement{};
+    }
+
+    void on_commit(std::size_t offset, std::size_t size) noexcept { rover = offset + size; }
+};
+
+// Takes the fitting gap that leaves the smallest remainder.
+struct BestFit {
+    Placement find(std::span<const Block> blocks, std::size_t capacity, std::size_t bytes,
+                   std::size_t alignment) const noexcept {
+        Placement best;
+        std::size_t best_remainder = Placement::npos;
+        for (std::size_t index = 0; index <= blocks.size(); ++index) {
+            const std::size_t aligned_offset = align_offset(gap_begin(blocks, index), alignment);
+            const std::size_t end = gap_end(blocks, index, capacity);
+            if (aligned_offset + bytes <= end && end - aligned_offset - bytes < best_remainder) {
+                best = Placement{aligned_offset, index};
+                best_remainder = end - aligned_offset - bytes;
+                if (best_remainder == 0) {
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    void on_commit(std::size_t, std::size_t) noexcept {}
+};
+
+// Takes the largest gap, keeping the leftover pieces as big as possible.
+struct WorstFit {
+    Placement find(std::span<const Block> blocks, std::size_t capacity, std::size_t bytes,
+                   std::size_t alignment) const noexcept {
+        Placement worst;
+        std::size_t worst_remainder = 0;
+        for (std::size_t index = 0; index <= blocks.size(); ++index) {
+            const std::size_t aligned_offset = align_offset(gap_begin(blocks, index), alignment);
+            const std::size_t end = gap_end(blocks, index, capacity);
+            if (aligned_offset + bytes <= end && (!worst.found() || end - aligned_offset - bytes > worst_remainder)) {
+                worst = Placement{aligned_offset, index};
+                worst_remainder = end - aligned_offset - bytes;
+            }
+        }
+        return worst;
+    }
+
+    void on_commit(std::size_t, std::size_t) noexcept {}
+};
+
+}  // namespace block_placement
+
+// Memory resource that can also report exhaustion by returning nullptr. allocate() keeps the
+// standard contract and throws std::bad_alloc; try_allocate() is the exception-free path for
+// hot loops and -fno-exceptions builds.
+class NothrowMemoryResource : public std::pmr::memory_resource {
 public:
-    explicit CustomBlockMemoryResource(std::size_t capacity_bytes, std::size_t buffer_alignment = 64)
+    [[nodiscard]] void* try_allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) noexcept {
+        return do_try_allocate(bytes, alignment);
+    }
+
+private:
+    virtual void* do_try_allocate(std::size_t bytes, std::size_t alignment) noexcept = 0;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* ptr = do_try_allocate(bytes, alignment);
+        if (ptr == nullptr) {
+            pmr_queue_throw(std::bad_alloc());
+        }
+        return ptr;
+    }
+};
+
+// Fixed-buffer memory resource; the placement strategy is chosen at compile time so the
+// search inlines into do_allocate.
+template <class PlacementPolicy>
+class BasicBlockMemoryResource : public NothrowMemoryResource {
+public:
+    using placement_policy = PlacementPolicy;
+    using pressure_callback = std::function<void(MemoryPressure previous, MemoryPressure current)>;
+
+    explicit BasicBlockMemoryResource(std::size_t capacity_bytes, std::size_t buffer_alignment = 64)
         : capacity_(capacity_bytes), buffer_alignment_(buffer_alignment) {
         if (capacity_bytes == 0) {
-            throw std::invalid_argument("Capacity must be greater than zero");
+            pmr_queue_throw(std::invalid_argument("Capacity must be greater than zero"));
         }
         if ((buffer_alignment_ & (buffer_alignment_ - 1)) != 0) {
-            throw std::invalid_argument("Alignment must be a power of two");
+            pmr_queue_throw(std::invalid_argument("Alignment must be a power of two"));
         }
         buffer_ = static_cast<std::byte*>(::operator new(capacity_bytes, std::align_val_t(buffer_alignment_)));
     }
 
-    ~CustomBlockMemoryResource() override {
+    BasicBlockMemoryResource(const BasicBlockMemoryResource&) = delete;
+    BasicBlockMemoryResource& operator=(const BasicBlockMemoryResource&) = delete;
+
+    ~BasicBlockMemoryResource() override {
         ::operator delete(buffer_, std::align_val_t(buffer_alignment_));
     }
 
     std::size_t capacity() const noexcept { return capacity_; }
+    std::size_t used_bytes() const noexcept { return used_bytes_; }
+    std::size_t block_count() const noexcept { return blocks_.size(); }
+
+    // Start of the managed buffer; block offsets are relative to it.
+    std::byte* data() noexcept { return buffer_; }
+    const std::byte* data() const noexcept { return buffer_; }
+
+    // Live blocks sorted by offset; with the buffer contents this is the whole allocation state.
+    const std::vector<block_placement::Block>& blocks() const noexcept { return blocks_; }
+
+    // Takes `blocks` as the live block table of an empty resource, e.g. after the buffer was
+    // filled from a snapshot. The blocks must be sorted, disjoint and inside the buffer.
+    void adopt_blocks(std::vector<block_placement::Block> blocks) {
+        if (!blocks_.empty()) {
+            pmr_queue_throw(std::logic_error("Blocks can only be adopted by an empty resource"));
+        }
+        std::size_t used = 0;
+        std::size_t previous_end = 0;
+        for (const block_placement::Block& block : blocks) {
+            if (block.size == 0 || block.offset < previous_end || block.offset > capacity_ ||
+                capacity_ - block.offset < block.size) {
+                pmr_queue_throw(std::invalid_argument("Blocks must be sorted, disjoint and inside the buffer"));
+            }
+            previous_end = block.offset + block.size;
+            used += block.size;
+        }
+        blocks_ = std::move(blocks);
+        used_bytes_ = used;
+        policy_ = PlacementPolicy{};
+        update_pressure(true);
+    }
+
+    // Size of the largest contiguous free range; linear in the number of live blocks.
+    std::size_t largest_free_gap() const noexcept {
+        std::size_t largest = 0;
+        for (std::size_t index = 0; index <= blocks_.size(); ++index) {
+            largest = std::max(largest, block_placement::gap_end(blocks_, index, capacity_) -
+                                            block_placement::gap_begin(blocks_, index));
+        }
+        return largest;
+    }
+
+    void set_watermarks(const MemoryWatermarks& watermarks) {
+        if (!ordered_ascending(watermarks.used_low, watermarks.used_high, watermarks.used_critical) ||
+            !ordered_ascending(watermarks.gap_critical, watermarks.gap_high, watermarks.gap_low)) {
+            pmr_queue_throw(std::invalid_argument("Watermarks must be ordered low < high < critical"));
+        }
+        watermarks_ = watermarks;
+        watermarks_enabled_ = watermarks.used_low != 0 || watermarks.used_high != 0 || watermarks.used_critical != 0 ||
+                              gap_checks_enabled();
+        used_level_ = level_for_used();
+        gap_level_ = gap_checks_enabled() ? level_for_gap() : MemoryPressure::normal;
+        ops_since_gap_check_ = 0;
+        publish_pressure();
+    }
+
+    // Invoked on the allocating thread whenever pressure() changes. The callback must not
+    // allocate from this resource, and must not throw since it also runs inside try_allocate().
+    void set_pressure_callback(pressure_callback callback) { on_pressure_change_ = std::move(callback); }
+
+    // Safe to poll from any thread.
+    MemoryPressure pressure() const noexcept { return pressure_.load(std::memory_order_relaxed); }
 
 private:
-    struct Block {
-        std::size_t offset;
-        std::size_t size;
-    };
+    using Block = block_placement::Block;
 
     std::size_t capacity_;
     std::size_t buffer_alignment_;
     std::byte* buffer_;
     std::vector<Block> blocks_;
+    std::size_t used_bytes_{0};
+    [[no_unique_address]] PlacementPolicy policy_;
+
+    MemoryWatermarks watermarks_{};
+    bool watermarks_enabled_{false};
+    MemoryPressure used_level_{MemoryPressure::normal};
+    MemoryPressure gap_level_{MemoryPressure::normal};
+    std::size_t ops_since_gap_check_{0};
+    std::atomic<MemoryPressure> pressure_{MemoryPressure::normal};
+    pressure_callback on_pressure_change_;
 
-    static std::size_t align_offset(std::size_t offset, std::size_t alignment) {
-        if (alignment == 0) {
-            return offset;
+    // Zero thresholds are skipped; the rest must grow strictly.
+    static bool ordered_ascending(std::size_t first, std::size_t second, std::size_t third) noexcept {
+        std::size_t previous = 0;
+        for (const std::size_t value : {first, second, third}) {
+            if (value != 0) {
+                if (value <= previous) {
+                    return false;
+                }
+                previous = value;
+            }
         }
-        const std::size_t remainder = offset % alignment;
-        return remainder == 0 ? offset : offset + (alignment - remainder);
+        return true;
     }
 
-    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    bool gap_checks_enabled() const noexcept {
+        return watermarks_.gap_low != 0 || watermarks_.gap_high != 0 || watermarks_.gap_critical != 0;
+    }
+
+    MemoryPressure level_for_used() const noexcept {
+        if (watermarks_.used_critical != 0 && used_bytes_ >= watermarks_.used_critical) {
+            return MemoryPressure::critical;
+        }
+        if (watermarks_.used_high != 0 && used_bytes_ >= watermarks_.used_high) {
+            return MemoryPressure::high;
+        }
+        if (watermarks_.used_low != 0 && used_bytes_ >= watermarks_.used_low) {
+            return MemoryPressure::low;
+        }
+        return MemoryPressure::normal;
+    }
+
+    MemoryPressure level_for_gap() const noexcept {
+        const std::size_t gap = largest_free_gap();
+        if (watermarks_.gap_critical != 0 && gap <= watermarks_.gap_critical) {
+            return MemoryPressure::critical;
+        }
+        if (watermarks_.gap_high != 0 && gap <= watermarks_.gap_high) {
+            return MemoryPressure::high;
+        }
+        if (watermarks_.gap_low != 0 && gap <= watermarks_.gap_low) {
+            return MemoryPressure::low;
+        }
+        return MemoryPressure::normal;
+    }
+
+    // Called after every successful allocate/deallocate; a single branch when disabled.
+    void update_pressure(bool force_gap_check = false) {
+        if (!watermarks_enabled_) {
+            return;
+        }
+        used_level_ = level_for_used();
+        if (gap_checks_enabled() && (force_gap_check || ++ops_since_gap_check_ >= watermarks_.gap_check_interval)) {
+            ops_since_gap_check_ = 0;
+            gap_level_ = level_for_gap();
+        }
+        publish_pressure();
+    }
+
+    void publish_pressure() {
+        const MemoryPressure current = std::max(used_level_, gap_level_);
+        const MemoryPressure previous = pressure_.load(std::memory_order_relaxed);
+        if (current == previous) {
+            return;
+        }
+        pressure_.store(current, std::memory_order_relaxed);
+        if (on_pressure_change_) {
+            on_pressure_change_(previous, current);
+        }
+    }
+
+    void* do_try_allocate(std::size_t bytes, std::size_t alignment) noexcept override {
         if (bytes == 0) {
             bytes = 1;
         }
         const std::size_t required_alignment = alignment == 0 ? alignof(std::max_align_t) : alignment;
         if (required_alignment > buffer_alignment_) {
-            throw std::bad_alloc();
+            return nullptr;
         }
 
-        std::size_t current_offset = 0;
-        for (const auto& block : blocks_) {
-            const std::size_t aligned_offset = align_offset(current_offset, required_alignment);
-            if (aligned_offset + bytes <= block.offset) {
-                return commit_block(aligned_offset, bytes);
-            }
-            current_offset = block.offset + block.size;
+        const block_placement::Placement placement = policy_.find(blocks_, capacity_, bytes, required_alignment);
+        if (!placement.found()) {
+            update_pressure(true);
+            return nullptr;
         }
+        void* ptr = nullptr;
+        // Growing the block table may itself run out of memory.
+        PMR_QUEUE_TRY {
+            ptr = commit_block(placement, bytes);
+        } PMR_QUEUE_CATCH(const std::bad_alloc&) {
+            return nullptr;
+        }
+        update_pressure();
+        return ptr;
+    }
 
-        const std::size_t aligned_offset = align_offset(current_offset, required_alignment);
-        if (aligned_offset + bytes > capacity_) {
-            throw std::bad_alloc();
+    // Qualified call, so the placement search still inlines into allocate().
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* ptr = BasicBlockMemoryResource::do_try_allocate(bytes, alignment);
+        if (ptr == nullptr) {
+            pmr_queue_throw(std::bad_alloc());
         }
-        return commit_block(aligned_offset, bytes);
+        return ptr;
     }
 
     void do_deallocate(void* ptr, std::size_t, std::size_t) override {
@@ -77,31 +390,64 @@ private:
 
         const auto byte_ptr = static_cast<std::byte*>(ptr);
         if (byte_ptr < buffer_ || byte_ptr >= buffer_ + capacity_) {
-            throw std::logic_error("Pointer does not belong to this resource");
+            pmr_queue_throw(std::logic_error("Pointer does not belong to this resource"));
         }
 
         const std::size_t offset = static_cast<std::size_t>(byte_ptr - buffer_);
         for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
             if (it->offset == offset) {
+                used_bytes_ -= it->size;
                 blocks_.erase(it);
+                update_pressure();
                 return;
             }
         }
-        throw std::logic_error("Attempt to deallocate unmanaged block");
+        pmr_queue_throw(std::logic_error("Attempt to deallocate unmanaged block"));
     }
 
     bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
         return this == &other;
     }
 
-    void* commit_block(std::size_t offset, std::size_t size) {
-        Block new_block{offset, size};
-        const auto insert_pos = std::lower_bound(
-            blocks_.begin(),
-            blocks_.end(),
-            new_block.offset,
-            [](const Block& lhs, std::size_t rhs) { return lhs.offset < rhs; });
-        blocks_.insert(insert_pos, new_block);
-        return buffer_ + offset;
+    void* commit_block(const block_placement::Placement& placement, std::size_t size) {
+        blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(placement.index), Block{placement.offset, size});
+        used_bytes_ += size;
+        policy_.on_commit(placement.offset, size);
+        return buffer_ + placement.offset;
+    }
+};
+
+using CustomBlockMemoryResource = BasicBlockMemoryResource<block_placement::FirstFit>;
+using NextFitBlockMemoryResource = BasicBlockMemoryResource<block_placement::NextFit>;
+using BestFitBlockMemoryResource = BasicBlockMemoryResource<block_placement::BestFit>;
+using WorstFitBlockMemoryResource = BasicBlockMemoryResource<block_placement::WorstFit>;
+
+// Serializes every call into `upstream` with a mutex, for resources that are not thread-safe
+// but end up shared between threads, e.g. by a queue and its background NodeReclaimer.
+class SynchronizedMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit SynchronizedMemoryResource(std::pmr::memory_resource* upstream) : upstream_(upstream) {}
+
+    SynchronizedMemoryResource(const SynchronizedMemoryResource&) = delete;
+    SynchronizedMemoryResource& operator=(const SynchronizedMemoryResource&) = delete;
+
+    std::pmr::memory_resource* upstream() const noexcept { return upstream_; }
+
+private:
+    std::mutex mutex_;
+    std::pmr::memory_resource* upstream_;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard lock(mutex_);
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard lock(mutex_);
+        upstream_->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
     }
 };
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "exception_config.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Nodes a container has unlinked but not yet destroyed. `drop` destroys `count` nodes starting
+// at `first`, following the container's own links, and returns their storage to `resource`.
+struct RetiredChain {
+    void* first{nullptr};
+    std::size_t count{0};
+    void (*drop)(void* first, std::size_t count, std::pmr::memory_resource* resource) noexcept {nullptr};
+    std::pmr::memory_resource* resource{nullptr};
+};
+
+enum class ReclaimMode { quiescent, background };
+
+// Takes chains of popped nodes off a consumer's critical path and destroys them later: on a
+// background thread, or on whichever thread calls quiesce(). Retiring is one short critical
+// section per chain, so containers hand over nodes in batches. Retired nodes stay allocated
+// until they are reclaimed; call quiesce() where exact used_bytes() matter. The resource is
+// deallocated from the reclaiming thread, so in background mode it must be thread-safe, e.g.
+// a SynchronizedMemoryResource. The reclaimer must outlive the containers that use it, and each
+// container's resource must outlive the reclaimer's last quiesce() or its destruction, which
+// deallocate whatever is still retired.
+class NodeReclaimer {
+public:
+    explicit NodeReclaimer(ReclaimMode mode = ReclaimMode::quiescent) {
+        if (mode == ReclaimMode::background) {
+            worker_ = std::thread([this] { run(); });
+        }
+    }
+
+    NodeReclaimer(const NodeReclaimer&) = delete;
+    NodeReclaimer& operator=(const NodeReclaimer&) = delete;
+
+    ~NodeReclaimer() {
+        if (worker_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_one();
+            worker_.join();
+        }
+        quiesce();
+    }
+
+    // Never fails: if the chain cannot be queued it is dropped right away.
+    void retire(const RetiredChain& chain) noexcept {
+        if (chain.count == 0) {
+            return;
+        }
+        bool queued = false;
+        PMR_QUEUE_TRY {
+            std::lock_guard lock(mutex_);
+            chains_.push_back(chain);
+            pending_ += chain.count;
+            queued = true;
+        } PMR_QUEUE_CATCH(...) {
+        }
+        if (!queued) {
+            chain.drop(chain.first, chain.count, chain.resource);
+            std::lock_guard lock(mutex_);
+            reclaimed_ += chain.count;
+            return;
+        }
+        wake_.notify_one();
+    }
+
+    // Reclaims everything retired so far on the calling thread; returns the node count.
+    std::size_t quiesce() noexcept {
+        std::vector<RetiredChain> batch;
+        {
+            std::lock_guard lock(mutex_);
+            batch.swap(chains_);
+        }
+        return reclaim(batch);
+    }
+
+    bool background() const noexcept { return worker_.joinable(); }
+
+    // Nodes retired and not yet destroyed.
+    std::size_t pending() const {
+        std::lock_guard lock(mutex_);
+        return pending_;
+    }
+
+    std::uint64_t reclaimed() const {
+        std::lock_guard lock(mutex_);
+        return reclaimed_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<RetiredChain> chains_;
+    std::size_t pending_{0};
+    std::uint64_t reclaimed_{0};
+    bool stopping_{false};
+    std::thread worker_;
+
+    std::size_t reclaim(std::vector<RetiredChain>& batch) noexcept {
+        std::size_t nodes = 0;
+        for (const RetiredChain& chain : batch) {
+            chain.drop(chain.first, chain.count, chain.resource);
+            nodes += chain.count;
+        }
+        if (nodes != 0) {
+            std::lock_guard lock(mutex_);
+            pending_ -= nodes;
+            reclaimed_ += nodes;
+        }
+        batch.clear();
+        return nodes;
+    }
+
+    void run() {
+        std::vector<RetiredChain> batch;
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this] { return stopping_ || !chains_.empty(); });
+            if (chains_.empty()) {
+                return;
+            }
+            // Swapping keeps both vectors' capacity, so steady state allocates nothing.
+            batch.swap(chains_);
+            lock.unlock();
+            reclaim(batch);
+            lock.lock();
+        }
+    }
+};
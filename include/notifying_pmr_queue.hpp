@@ -0,0 +1,163 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+// Multi-producer queue for consumers that run an epoll/poll/select loop. fd() is a
+// non-blocking eventfd that becomes readable when the queue goes from empty to non-empty;
+// pushes into a non-empty queue do not touch it, so a burst costs one write() however long it
+// is. Register fd() for EPOLLIN and, when it fires, call drain(), which acknowledges the
+// eventfd before taking the elements: anything pushed after the acknowledgement either is
+// drained as well or finds the queue empty and signals again, so no wakeup is lost. A wakeup
+// may find the queue already drained, which is harmless.
+template <class T>
+class NotifyingPmrQueue {
+public:
+    using value_type = T;
+
+    explicit NotifyingPmrQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource), queue_(resource) {
+        event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "eventfd");
+        }
+    }
+
+    NotifyingPmrQueue(const NotifyingPmrQueue&) = delete;
+    NotifyingPmrQueue& operator=(const NotifyingPmrQueue&) = delete;
+
+    ~NotifyingPmrQueue() {
+        ::close(event_fd_);
+    }
+
+    int fd() const noexcept { return event_fd_; }
+
+    template <class... Args>
+    void emplace(Args&&... args) {
+        bool was_empty = false;
+        {
+            std::lock_guard lock(mutex_);
+            was_empty = queue_.empty();
+            queue_.emplace(std::forward<Args>(args)...);
+            notifications_ += was_empty ? 1 : 0;
+        }
+        if (was_empty) {
+            signal();
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // Does not touch the eventfd; loops that pop this way must still acknowledge() on wakeup.
+    bool try_pop(T& out) {
+        std::lock_guard lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+        out = std::move(queue_.front());
+        queue_.pop();
+        return true;
+    }
+
+    // Acknowledges the eventfd, then passes every queued element to `consumer` outside the
+    // lock. Returns how many elements were consumed. If `consumer` throws, the element it was
+    // given counts as consumed; the ones after it go back to the front of the queue and the
+    // eventfd is signaled again before the exception propagates.
+    template <class Consumer>
+    std::size_t drain(Consumer&& consumer) {
+        acknowledge();
+        PmrQueue<T> batch(resource_);
+        {
+            std::lock_guard lock(mutex_);
+            batch.splice(queue_);
+        }
+        std::size_t consumed = 0;
+        while (!batch.empty()) {
+            try {
+                consumer(batch.front());
+            } catch (...) {
+                requeue(batch);
+                throw;
+            }
+            // The resource is shared with the producers, so nodes are released under the lock.
+            std::lock_guard lock(mutex_);
+            batch.pop();
+            ++consumed;
+        }
+        return consumed;
+    }
+
+    // Resets the eventfd counter; returns false if it was not signaled.
+    bool acknowledge() {
+        std::uint64_t count = 0;
+        while (::read(event_fd_, &count, sizeof(count)) < 0) {
+            if (errno == EAGAIN) {
+                return false;
+            }
+            if (errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(), "eventfd read");
+            }
+        }
+        return true;
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return queue_.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // eventfd writes so far, i.e. empty-to-non-empty transitions.
+    std::uint64_t notifications() const {
+        std::lock_guard lock(mutex_);
+        return notifications_;
+    }
+
+private:
+    std::pmr::memory_resource* resource_;
+    mutable std::mutex mutex_;
+    PmrQueue<T> queue_;
+    std::uint64_t notifications_{0};
+    int event_fd_{-1};
+
+    // Drops the front of `batch` and puts the rest back ahead of anything pushed meanwhile.
+    void requeue(PmrQueue<T>& batch) {
+        bool pending = false;
+        {
+            std::lock_guard lock(mutex_);
+            batch.pop();
+            batch.splice(queue_);
+            queue_.splice(batch);
+            pending = !queue_.empty();
+            notifications_ += pending ? 1 : 0;
+        }
+        if (pending) {
+            signal();
+        }
+    }
+
+    void signal() {
+        const std::uint64_t one = 1;
+        while (::write(event_fd_, &one, sizeof(one)) < 0) {
+            // EAGAIN means the counter is saturated, so the fd is readable anyway.
+            if (errno == EAGAIN) {
+                return;
+            }
+            if (errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(), "eventfd write");
+            }
+        }
+    }
+};
@@ -1,23 +1,87 @@
 #pragma once
 
+#include "exception_config.hpp"
+#include "memory_resource.hpp"
+#include "node_reclaimer.hpp"
+#include "queue_telemetry.hpp"
+
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <memory_resource>
+#include <new>
 #include <stdexcept>
 #include <utility>
 
+// Hit/miss counters of the optional node cache inside PmrQueue. Nodes served from reserve()
+// slabs are counted separately and do not enter hit_rate().
+struct PmrQueueCacheStats {
+    std::size_t hits{0};
+    std::size_t misses{0};
+    std::size_t reserve_hits{0};
+
+    double hit_rate() const noexcept {
+        const std::size_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+// Position-independent description of a PmrQueue whose nodes all live in one buffer: each
+// list head is an offset from the buffer start, or null_offset. The links stored inside the
+// nodes stay absolute, so base_address records where the buffer was when the image was taken.
+struct PmrQueueImage {
+    static constexpr std::uint64_t null_offset = UINT64_MAX;
+
+    std::uint64_t base_address{0};
+    std::uint64_t head{null_offset};
+    std::uint64_t tail{null_offset};
+    std::uint64_t size{0};
+    std::uint64_t cache{null_offset};
+    std::uint64_t cached{0};
+    std::uint64_t cache_limit{0};
+    std::uint64_t reserve{null_offset};
+    std::uint64_t reserved_free{0};
+    std::uint64_t slabs{null_offset};
+};
+
 // Queue container that uses std::pmr::polymorphic_allocator for memory management.
-template <class T>
+// Elements are built by uses-allocator construction, so pmr-aware types allocate their own
+// internals from the queue's resource as well. Popped nodes can optionally be kept in a
+// bounded per-queue cache and reused by the next emplace() without going back to the memory
+// resource, and reserve() pre-allocates nodes in a single resource call ahead of a known
+// burst. The Telemetry policy (see queue_telemetry.hpp) can stamp elements and record sojourn
+// times; the default NoQueueTelemetry adds no storage and no code. The try_* members never
+// throw on an empty queue or on exhaustion of a NothrowMemoryResource, and the header builds
+// with -fno-exceptions. With set_reclaimer(), pop() only unlinks the node and element
+// destructors run later on a NodeReclaimer.
+template <class T, class Telemetry = NoQueueTelemetry>
 class PmrQueue {
 private:
     struct Node {
         template <class... Args>
-        explicit Node(Args&&... args) : value(std::forward<Args>(args)...), next(nullptr) {}
+        explicit Node(const std::pmr::polymorphic_allocator<>& alloc, Args&&... args)
+            : value(std::make_obj_using_allocator<T>(alloc, std::forward<Args>(args)...)), next(nullptr) {}
         T value;
         Node* next;
+        [[no_unique_address]] typename Telemetry::Stamp stamp{};
     };
 
+    // Overlays the storage of a destroyed node while it sits in the cache.
+    struct CachedNode {
+        CachedNode* next;
+    };
+    static_assert(sizeof(Node) >= sizeof(CachedNode) && alignof(Node) >= alignof(CachedNode));
+
+    // Header of a block of nodes carved out by reserve(); the nodes follow it.
+    struct Slab {
+        Slab* next;
+        std::size_t count;
+    };
+
+    static constexpr std::size_t slab_alignment = alignof(Slab) > alignof(Node) ? alignof(Slab) : alignof(Node);
+    static constexpr std::size_t slab_header_bytes = (sizeof(Slab) + alignof(Node) - 1) / alignof(Node) * alignof(Node);
+
     using allocator_type = std::pmr::polymorphic_allocator<Node>;
 
 public:
@@ -64,50 +128,50 @@ public:
     explicit PmrQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
         : allocator_(resource) {}
 
+    // Picked for resources that can fail without throwing; try_emplace() then uses try_allocate().
+    explicit PmrQueue(NothrowMemoryResource* resource)
+        : allocator_(resource), nothrow_resource_(resource) {}
+
     PmrQueue(const PmrQueue&) = delete;
     PmrQueue& operator=(const PmrQueue&) = delete;
 
     PmrQueue(PmrQueue&& other) noexcept
-        : allocator_(other.allocator_),
-          head_(other.head_),
-          tail_(other.tail_),
-          size_(other.size_) {
-        other.head_ = nullptr;
-        other.tail_ = nullptr;
-        other.size_ = 0;
+        : allocator_(other.allocator_), nothrow_resource_(other.nothrow_resource_), telemetry_(other.telemetry_) {
+        take_storage(other);
     }
 
     PmrQueue& operator=(PmrQueue&& other) noexcept {
         if (this == &other) {
             return *this;
         }
-        destroy_all();
+        release_storage();
         allocator_ = other.allocator_;
-        head_ = other.head_;
-        tail_ = other.tail_;
-        size_ = other.size_;
-        other.head_ = nullptr;
-        other.tail_ = nullptr;
-        other.size_ = 0;
+        nothrow_resource_ = other.nothrow_resource_;
+        telemetry_ = other.telemetry_;
+        take_storage(other);
         return *this;
     }
 
     ~PmrQueue() {
-        destroy_all();
+        release_storage();
     }
 
     template <class... Args>
     void emplace(Args&&... args) {
-        Node* new_node = allocator_.allocate(1);
-        std::allocator_traits<allocator_type>::construct(allocator_, new_node, std::forward<Args>(args)...);
+        Node* new_node = acquire_node();
+        construct_and_link(new_node, std::forward<Args>(args)...);
+    }
 
-        if (tail_ == nullptr) {
-            head_ = tail_ = new_node;
-        } else {
-            tail_->next = new_node;
-            tail_ = new_node;
+    // Returns false instead of throwing when no node can be obtained. Exceptions thrown by the
+    // element constructor still propagate.
+    template <class... Args>
+    bool try_emplace(Args&&... args) {
+        Node* new_node = try_acquire_node();
+        if (new_node == nullptr) {
+            return false;
         }
-        ++size_;
+        construct_and_link(new_node, std::forward<Args>(args)...);
+        return true;
     }
 
     void push(const T& value) { emplace(value); }
@@ -115,47 +179,452 @@ public:
 
     void pop() {
         if (empty()) {
-            throw std::out_of_range("Queue is empty");
+            pmr_queue_throw(std::out_of_range("Queue is empty"));
         }
+        pop_head();
+    }
 
-        Node* old_head = head_;
-        head_ = head_->next;
-        if (head_ == nullptr) {
-            tail_ = nullptr;
+    // Moves the front element into `out` and pops it; returns false on an empty queue.
+    bool try_pop(T& out) {
+        if (empty()) {
+            return false;
         }
-        std::allocator_traits<allocator_type>::destroy(allocator_, old_head);
-        allocator_.deallocate(old_head, 1);
-        --size_;
+        out = std::move(head_->value);
+        pop_head();
+        return true;
     }
 
     T& front() {
         if (empty()) {
-            throw std::out_of_range("Queue is empty");
+            pmr_queue_throw(std::out_of_range("Queue is empty"));
         }
         return head_->value;
     }
 
     const T& front() const {
         if (empty()) {
-            throw std::out_of_range("Queue is empty");
+            pmr_queue_throw(std::out_of_range("Queue is empty"));
         }
         return head_->value;
     }
 
+    T* try_front() noexcept { return empty() ? nullptr : std::addressof(head_->value); }
+    const T* try_front() const noexcept { return empty() ? nullptr : std::addressof(head_->value); }
+
+    // Moves every element of `other` to the back of this queue. Nodes are relinked in O(1)
+    // when both queues share a resource, otherwise the elements are moved one by one.
+    void splice(PmrQueue& other) {
+        if (this == &other || other.empty()) {
+            return;
+        }
+        // Nodes reserved by `other` must go back to its own slabs, so they are not relinked.
+        if (allocator_ != other.allocator_ || other.slabs_ != nullptr) {
+            while (!other.empty()) {
+                emplace(std::move(other.front()));
+                other.pop();
+            }
+            return;
+        }
+
+        if (tail_ == nullptr) {
+            head_ = other.head_;
+        } else {
+            tail_->next = other.head_;
+        }
+        tail_ = other.tail_;
+        size_ += other.size_;
+        telemetry_.on_transfer_in(other.size_, size_);
+        other.telemetry_.on_transfer_out(other.size_, 0);
+        other.head_ = nullptr;
+        other.tail_ = nullptr;
+        other.size_ = 0;
+    }
+
     bool empty() const noexcept { return head_ == nullptr; }
+    std::size_t size() const noexcept { return size_; }
+
+    // Number of elements the queue can hold without calling the memory resource.
+    std::size_t capacity() const noexcept { return size_ + cached_ + reserved_free_; }
+
+    std::pmr::memory_resource* resource() const noexcept { return allocator_.resource(); }
+
+    Telemetry& telemetry() noexcept { return telemetry_; }
+    const Telemetry& telemetry() const noexcept { return telemetry_; }
+
+    // Keeps up to `limit` popped nodes for reuse; 0 (the default) disables the cache.
+    // Lowering the limit releases the surplus immediately.
+    void set_node_cache_limit(std::size_t limit) {
+        cache_limit_ = limit;
+        while (cached_ > cache_limit_) {
+            deallocate_cached();
+        }
+    }
+
+    std::size_t node_cache_limit() const noexcept { return cache_limit_; }
+
+    // Hands popped nodes to `reclaimer` in chains of `batch` instead of destroying them in pop().
+    // Nodes carved out by reserve() are still recycled inline, but no other popped node reaches
+    // the node cache while a reclaimer is set, so emplace() allocates from the resource once the
+    // cache is used up. nullptr restores inline destruction; nodes retired so far are flushed to
+    // the previous reclaimer first.
+    void set_reclaimer(NodeReclaimer* reclaimer, std::size_t batch = 64) noexcept {
+        flush_retired();
+        reclaimer_ = reclaimer;
+        retire_batch_ = batch == 0 ? 1 : batch;
+    }
+
+    NodeReclaimer* reclaimer() const noexcept { return reclaimer_; }
+
+    // Passes the partial chain of retired nodes to the reclaimer, e.g. before its quiesce().
+    void flush_retired() noexcept {
+        if (retired_count_ == 0) {
+            return;
+        }
+        reclaimer_->retire(RetiredChain{retired_head_, retired_count_, &drop_chain, resource()});
+        retired_head_ = nullptr;
+        retired_tail_ = nullptr;
+        retired_count_ = 0;
+    }
+
+    // Popped nodes waiting to be handed to the reclaimer.
+    std::size_t retired_nodes() const noexcept { return retired_count_; }
+    std::size_t cached_nodes() const noexcept { return cached_; }
+    PmrQueueCacheStats node_cache_stats() const noexcept { return cache_stats_; }
+
+    // Returns every cached node to the memory resource. Reserved nodes are kept.
+    void shrink() noexcept {
+        while (cache_ != nullptr) {
+            deallocate_cached();
+        }
+    }
+
+    // Makes room for `count` elements in total. The missing nodes are carved out of one
+    // allocation, so a following burst of up to `count` pushes never reaches the resource.
+    void reserve(std::size_t count) {
+        if (count <= capacity()) {
+            return;
+        }
+        const std::size_t missing = count - capacity();
+        void* raw = resource()->allocate(slab_header_bytes + missing * sizeof(Node), slab_alignment);
+        Slab* slab = ::new (raw) Slab{slabs_, missing};
+        slabs_ = slab;
+        Node* nodes = slab_nodes(slab);
+        for (std::size_t index = missing; index-- > 0;) {
+            reserve_ = ::new (static_cast<void*>(nodes + index)) CachedNode{reserve_};
+        }
+        reserved_free_ += missing;
+    }
+
+    // Releases cached nodes and every reserved slab none of whose nodes is in use.
+    void shrink_to_fit() noexcept {
+        shrink();
+        Slab** link = &slabs_;
+        while (*link != nullptr) {
+            Slab* slab = *link;
+            if (free_nodes_in(slab) == slab->count) {
+                unlink_free_nodes_in(slab);
+                *link = slab->next;
+                deallocate_slab(slab);
+            } else {
+                link = &slab->next;
+            }
+        }
+    }
 
     iterator begin() noexcept { return iterator(head_); }
     iterator end() noexcept { return iterator(nullptr); }
 
+    static constexpr std::size_t node_size() noexcept { return sizeof(Node); }
+
+    // Describes the queue relative to `base`, which must contain every node and slab. Retired
+    // nodes are not part of the image and would leak in a copy of the buffer, so with a
+    // reclaimer call flush_retired() and let it quiesce() first.
+    PmrQueueImage image(const std::byte* base) const {
+        if (retired_count_ != 0 || (reclaimer_ != nullptr && reclaimer_->pending() != 0)) {
+            pmr_queue_throw(std::logic_error("Retired nodes must be reclaimed before taking an image"));
+        }
+        PmrQueueImage result;
+        result.base_address = reinterpret_cast<std::uintptr_t>(base);
+        result.head = offset_in(base, head_);
+        result.tail = offset_in(base, tail_);
+        result.size = size_;
+        result.cache = offset_in(base, cache_);
+        result.cached = cached_;
+        result.cache_limit = cache_limit_;
+        result.reserve = offset_in(base, reserve_);
+        result.reserved_free = reserved_free_;
+        result.slabs = offset_in(base, slabs_);
+        return result;
+    }
+
+    // Adopts the nodes of `image` after their buffer was copied to `base`, e.g. from a snapshot.
+    // The queue must be empty and own no storage. If the buffer moved, every link stored in a
+    // node is relocated by the distance it moved, which is one pass over the nodes.
+    void restore_image(const PmrQueueImage& image, std::byte* base) {
+        if (!empty() || cache_ != nullptr || slabs_ != nullptr || retired_count_ != 0) {
+            pmr_queue_throw(std::logic_error("Image can only be restored into an empty queue"));
+        }
+        head_ = pointer_in<Node>(base, image.head);
+        tail_ = pointer_in<Node>(base, image.tail);
+        size_ = static_cast<std::size_t>(image.size);
+        cache_ = pointer_in<CachedNode>(base, image.cache);
+        cached_ = static_cast<std::size_t>(image.cached);
+        cache_limit_ = static_cast<std::size_t>(image.cache_limit);
+        reserve_ = pointer_in<CachedNode>(base, image.reserve);
+        reserved_free_ = static_cast<std::size_t>(image.reserved_free);
+        slabs_ = pointer_in<Slab>(base, image.slabs);
+
+        const std::uintptr_t new_address = reinterpret_cast<std::uintptr_t>(base);
+        if (new_address == image.base_address) {
+            return;
+        }
+        const auto relocate = [&](auto* pointer) {
+            return pointer == nullptr
+                       ? pointer
+                       : reinterpret_cast<decltype(pointer)>(reinterpret_cast<std::uintptr_t>(pointer) -
+                                                             image.base_address + new_address);
+        };
+        for (Node* node = head_; node != nullptr; node = node->next) {
+            node->next = relocate(node->next);
+        }
+        for (CachedNode* list : {cache_, reserve_}) {
+            for (CachedNode* node = list; node != nullptr; node = node->next) {
+                node->next = relocate(node->next);
+            }
+        }
+        for (Slab* slab = slabs_; slab != nullptr; slab = slab->next) {
+            slab->next = relocate(slab->next);
+        }
+    }
+
 private:
     allocator_type allocator_;
+    NothrowMemoryResource* nothrow_resource_{nullptr};
     Node* head_{nullptr};
     Node* tail_{nullptr};
     std::size_t size_{0};
+    CachedNode* cache_{nullptr};
+    std::size_t cached_{0};
+    std::size_t cache_limit_{0};
+    PmrQueueCacheStats cache_stats_{};
+    CachedNode* reserve_{nullptr};
+    std::size_t reserved_free_{0};
+    Slab* slabs_{nullptr};
+    NodeReclaimer* reclaimer_{nullptr};
+    std::size_t retire_batch_{64};
+    Node* retired_head_{nullptr};
+    Node* retired_tail_{nullptr};
+    std::size_t retired_count_{0};
+    [[no_unique_address]] Telemetry telemetry_;
+
+    static std::uint64_t offset_in(const std::byte* base, const void* pointer) noexcept {
+        return pointer == nullptr ? PmrQueueImage::null_offset
+                                  : static_cast<std::uint64_t>(static_cast<const std::byte*>(pointer) - base);
+    }
+
+    template <class Pointee>
+    static Pointee* pointer_in(std::byte* base, std::uint64_t offset) noexcept {
+        return offset == PmrQueueImage::null_offset ? nullptr : reinterpret_cast<Pointee*>(base + offset);
+    }
+
+    static Node* slab_nodes(Slab* slab) noexcept {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::byte*>(slab) + slab_header_bytes);
+    }
+
+    static bool slab_contains(Slab* slab, const void* node) noexcept {
+        const Node* first = slab_nodes(slab);
+        return node >= first && node < first + slab->count;
+    }
+
+    bool owned_by_slab(const Node* node) const noexcept {
+        for (Slab* slab = slabs_; slab != nullptr; slab = slab->next) {
+            if (slab_contains(slab, node)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reserved nodes first, then the cache; nullptr if both are empty.
+    Node* take_cached_node() noexcept {
+        CachedNode** list = reserve_ != nullptr ? &reserve_ : &cache_;
+        if (*list == nullptr) {
+            ++cache_stats_.misses;
+            return nullptr;
+        }
+        ++(list == &reserve_ ? cache_stats_.reserve_hits : cache_stats_.hits);
+        CachedNode* cached = *list;
+        *list = cached->next;
+        --(list == &reserve_ ? reserved_free_ : cached_);
+        return reinterpret_cast<Node*>(cached);
+    }
+
+    Node* acquire_node() {
+        Node* node = take_cached_node();
+        return node != nullptr ? node : allocator_.allocate(1);
+    }
+
+    // Without a NothrowMemoryResource a failing allocation can only be observed as an
+    // exception, so with exceptions disabled it terminates like allocate() would.
+    Node* try_acquire_node() {
+        if (Node* node = take_cached_node()) {
+            return node;
+        }
+        if (nothrow_resource_ != nullptr) {
+            return static_cast<Node*>(nothrow_resource_->try_allocate(sizeof(Node), alignof(Node)));
+        }
+        Node* node = nullptr;
+        PMR_QUEUE_TRY {
+            node = allocator_.allocate(1);
+        } PMR_QUEUE_CATCH(const std::bad_alloc&) {
+            return nullptr;
+        }
+        return node;
+    }
+
+    template <class... Args>
+    void construct_and_link(Node* new_node, Args&&... args) {
+        PMR_QUEUE_TRY {
+            std::allocator_traits<allocator_type>::construct(
+                allocator_, new_node, std::pmr::polymorphic_allocator<>(allocator_), std::forward<Args>(args)...);
+        } PMR_QUEUE_CATCH(...) {
+            release_node(new_node);
+            PMR_QUEUE_RETHROW;
+        }
+
+        if (tail_ == nullptr) {
+            head_ = tail_ = new_node;
+        } else {
+            tail_->next = new_node;
+            tail_ = new_node;
+        }
+        ++size_;
+        new_node->stamp = telemetry_.on_push(size_);
+    }
+
+    void pop_head() noexcept {
+        Node* old_head = head_;
+        head_ = head_->next;
+        if (head_ == nullptr) {
+            tail_ = nullptr;
+        }
+        const typename Telemetry::Stamp stamp = old_head->stamp;
+        if (reclaimer_ != nullptr && !(slabs_ != nullptr && owned_by_slab(old_head))) {
+            retire(old_head);
+        } else {
+            std::allocator_traits<allocator_type>::destroy(allocator_, old_head);
+            release_node(old_head);
+        }
+        --size_;
+        telemetry_.on_pop(stamp, size_);
+    }
+
+    void retire(Node* node) noexcept {
+        node->next = nullptr;
+        if (retired_tail_ == nullptr) {
+            retired_head_ = node;
+        } else {
+            retired_tail_->next = node;
+        }
+        retired_tail_ = node;
+        if (++retired_count_ >= retire_batch_) {
+            flush_retired();
+        }
+    }
+
+    // RetiredChain::drop for this node type; runs on the reclaiming thread.
+    static void drop_chain(void* first, std::size_t count, std::pmr::memory_resource* resource) noexcept {
+        allocator_type allocator(resource);
+        Node* node = static_cast<Node*>(first);
+        for (; count > 0; --count) {
+            Node* next = node->next;
+            std::allocator_traits<allocator_type>::destroy(allocator, node);
+            allocator.deallocate(node, 1);
+            node = next;
+        }
+    }
+
+    // Takes the storage of a destroyed (or never constructed) node.
+    void release_node(Node* node) noexcept {
+        if (slabs_ != nullptr && owned_by_slab(node)) {
+            reserve_ = ::new (static_cast<void*>(node)) CachedNode{reserve_};
+            ++reserved_free_;
+            return;
+        }
+        if (cached_ < cache_limit_) {
+            cache_ = ::new (static_cast<void*>(node)) CachedNode{cache_};
+            ++cached_;
+            return;
+        }
+        allocator_.deallocate(node, 1);
+    }
+
+    std::size_t free_nodes_in(Slab* slab) const noexcept {
+        std::size_t count = 0;
+        for (CachedNode* node = reserve_; node != nullptr; node = node->next) {
+            count += slab_contains(slab, node) ? 1 : 0;
+        }
+        return count;
+    }
+
+    void unlink_free_nodes_in(Slab* slab) noexcept {
+        CachedNode** link = &reserve_;
+        while (*link != nullptr) {
+            if (slab_contains(slab, *link)) {
+                *link = (*link)->next;
+                --reserved_free_;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+
+    void deallocate_slab(Slab* slab) noexcept {
+        resource()->deallocate(slab, slab_header_bytes + slab->count * sizeof(Node), slab_alignment);
+    }
+
+    // Destroys every element and returns all node storage to the resource.
+    void release_storage() noexcept {
+        destroy_all();
+        flush_retired();
+        shrink();
+        while (slabs_ != nullptr) {
+            Slab* slab = slabs_;
+            slabs_ = slab->next;
+            deallocate_slab(slab);
+        }
+        reserve_ = nullptr;
+        reserved_free_ = 0;
+    }
+
+    void take_storage(PmrQueue& other) noexcept {
+        head_ = std::exchange(other.head_, nullptr);
+        tail_ = std::exchange(other.tail_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        cache_ = std::exchange(other.cache_, nullptr);
+        cached_ = std::exchange(other.cached_, 0);
+        cache_limit_ = other.cache_limit_;
+        cache_stats_ = other.cache_stats_;
+        reserve_ = std::exchange(other.reserve_, nullptr);
+        reserved_free_ = std::exchange(other.reserved_free_, 0);
+        slabs_ = std::exchange(other.slabs_, nullptr);
+        reclaimer_ = other.reclaimer_;
+        retire_batch_ = other.retire_batch_;
+        retired_head_ = std::exchange(other.retired_head_, nullptr);
+        retired_tail_ = std::exchange(other.retired_tail_, nullptr);
+        retired_count_ = std::exchange(other.retired_count_, 0);
+    }
+
+    void deallocate_cached() noexcept {
+        CachedNode* cached = cache_;
+        cache_ = cached->next;
+        --cached_;
+        allocator_.deallocate(reinterpret_cast<Node*>(cached), 1);
+    }
 
     void destroy_all() noexcept {
         while (!empty()) {
-            pop();
+            pop_head();
         }
     }
 };
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Converts queue elements to bytes and back, e.g. for SpillingPmrQueue segment files.
+// write() appends one element to `out`; read() consumes one element from the front of `in`
+// and builds it with `alloc`, so pmr-aware types land in the queue's resource. The primary
+// template covers trivially copyable types; specialize it for anything else.
+template <class T>
+struct QueueSerializer {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Specialize QueueSerializer<T> for types that are not trivially copyable");
+
+    static void write(const T& value, std::vector<std::byte>& out) {
+        const std::size_t offset = out.size();
+        out.resize(offset + sizeof(T));
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    static T read(std::span<const std::byte>& in, const std::pmr::polymorphic_allocator<>&) {
+        if (in.size() < sizeof(T)) {
+            throw std::runtime_error("Truncated queue record");
+        }
+        T value;
+        std::memcpy(&value, in.data(), sizeof(T));
+        in = in.subspan(sizeof(T));
+        return value;
+    }
+};
+
+// Length-prefixed characters for std::pmr::basic_string.
+template <class CharT, class Traits>
+struct QueueSerializer<std::basic_string<CharT, Traits, std::pmr::polymorphic_allocator<CharT>>> {
+    using string_type = std::basic_string<CharT, Traits, std::pmr::polymorphic_allocator<CharT>>;
+
+    static void write(const string_type& value, std::vector<std::byte>& out) {
+        QueueSerializer<std::uint64_t>::write(value.size(), out);
+        const std::size_t offset = out.size();
+        out.resize(offset + value.size() * sizeof(CharT));
+        std::memcpy(out.data() + offset, value.data(), value.size() * sizeof(CharT));
+    }
+
+    static string_type read(std::span<const std::byte>& in, const std::pmr::polymorphic_allocator<>& alloc) {
+        const std::uint64_t length = QueueSerializer<std::uint64_t>::read(in, alloc);
+        if (in.size() / sizeof(CharT) < length) {
+            throw std::runtime_error("Truncated queue record");
+        }
+        string_type value(static_cast<std::size_t>(length), CharT{}, alloc);
+        std::memcpy(value.data(), in.data(), value.size() * sizeof(CharT));
+        in = in.subspan(value.size() * sizeof(CharT));
+        return value;
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "compact_pmr_queue.hpp"
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary snapshots of a queue together with the BasicBlockMemoryResource that holds its nodes.
+// The file stores a header, the queue image, the block table and then the used prefix of the
+// buffer at a 4 KiB-aligned offset. Restoring reads that prefix straight into the buffer of an
+// empty resource and adopts the block table, so its cost is the read itself plus, for
+// PmrQueue when the buffer lands at a different address, one link fixup per node;
+// CompactPmrQueue needs none. Elements are copied as raw bytes, so T must be trivially
+// copyable, and a snapshot is only meant to be restored by the same build.
+
+namespace queue_snapshot_detail {
+
+enum class QueueKind : std::uint32_t { pointer_links = 1, offset_links = 2 };
+
+struct Header {
+    char magic[8];
+    QueueKind kind;
+    std::uint32_t node_size;
+    std::uint64_t capacity;
+    std::uint64_t extent;
+    std::uint64_t block_count;
+    std::uint64_t image_bytes;
+};
+
+inline constexpr char kMagic[8] = {'P', 'M', 'R', 'S', 'N', 'P', '0', '1'};
+inline constexpr std::uint64_t kDataAlignment = 4096;
+
+inline std::uint64_t data_offset(const Header& header) noexcept {
+    const std::uint64_t table_end = sizeof(Header) + header.image_bytes + header.block_count * 2 * sizeof(std::uint64_t);
+    return (table_end + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+}
+
+template <class Policy, class Image>
+void write(const std::filesystem::path& path, const BasicBlockMemoryResource<Policy>& resource, QueueKind kind,
+           std::size_t node_size, const Image& image) {
+    const std::vector<block_placement::Block>& blocks = resource.blocks();
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.kind = kind;
+    header.node_size = static_cast<std::uint32_t>(node_size);
+    header.capacity = resource.capacity();
+    header.extent = blocks.empty() ? 0 : blocks.back().offset + blocks.back().size;
+    header.block_count = blocks.size();
+    header.image_bytes = sizeof(Image);
+
+    std::vector<std::uint64_t> table;
+    table.reserve(blocks.size() * 2);
+    for (const block_placement::Block& block : blocks) {
+        table.push_back(block.offset);
+        table.push_back(block.size);
+    }
+    const std::uint64_t padding = data_offset(header) - sizeof(Header) - sizeof(Image) - table.size() * sizeof(std::uint64_t);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&image), sizeof(image));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(std::uint64_t)));
+    const std::vector<char> zeros(static_cast<std::size_t>(padding));
+    out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    out.write(reinterpret_cast<const char*>(resource.data()), static_cast<std::streamsize>(header.extent));
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write queue snapshot " + path.string());
+    }
+}
+
+// Fills the resource and returns the queue image; the queue itself is left to the caller.
+template <class Policy, class Image>
+Image read(const std::filesystem::path& path, BasicBlockMemoryResource<Policy>& resource, QueueKind kind,
+           std::size_t node_size) {
+    std::ifstream in(path, std::ios::binary);
+    Header header{};
+    Image image{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a queue snapshot: " + path.string());
+    }
+    if (header.kind != kind || header.node_size != node_size || header.image_bytes != sizeof(Image)) {
+        throw std::runtime_error("Snapshot holds a different queue type: " + path.string());
+    }
+    if (header.extent > resource.capacity()) {
+        throw std::invalid_argument("Snapshot does not fit the resource buffer");
+    }
+    if (resource.block_count() != 0) {
+        throw std::logic_error("Snapshots can only be restored into an empty resource");
+    }
+
+    in.read(reinterpret_cast<char*>(&image), sizeof(image));
+    std::vector<std::uint64_t> table(static_cast<std::size_t>(header.block_count) * 2);
+    in.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(std::uint64_t)));
+    in.seekg(static_cast<std::streamoff>(data_offset(header)));
+    in.read(reinterpret_cast<char*>(resource.data()), static_cast<std::streamsize>(header.extent));
+    if (!in) {
+        throw std::runtime_error("Truncated queue snapshot " + path.string());
+    }
+
+    std::vector<block_placement::Block> blocks(static_cast<std::size_t>(header.block_count));
+    for (std::size_t index = 0; index < blocks.size(); ++index) {
+        blocks[index] = block_placement::Block{static_cast<std::size_t>(table[2 * index]),
+                                               static_cast<std::size_t>(table[2 * index + 1])};
+    }
+    resource.adopt_blocks(std::move(blocks));
+    return image;
+}
+
+}  // namespace queue_snapshot_detail
+
+// Every node of `queue` must come from `resource`, and none may be waiting on a reclaimer.
+template <class Policy, class T, class Telemetry>
+void snapshot_queue(const std::filesystem::path& path, const BasicBlockMemoryResource<Policy>& resource,
+                    const PmrQueue<T, Telemetry>& queue) {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy elements as raw bytes");
+    if (queue.resource() != &resource) {
+        throw std::invalid_argument("Queue does not allocate from this resource");
+    }
+    queue_snapshot_detail::write(path, resource, queue_snapshot_detail::QueueKind::pointer_links,
+                                 PmrQueue<T, Telemetry>::node_size(), queue.image(resource.data()));
+}
+
+// `resource` must be empty and `queue` must be an empty queue on it.
+template <class Policy, class T, class Telemetry>
+void restore_queue(const std::filesystem::path& path, BasicBlockMemoryResource<Policy>& resource,
+                   PmrQueue<T, Telemetry>& queue) {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy elements as raw bytes");
+    if (queue.resource() != &resource || !queue.empty()) {
+        throw std::invalid_argument("Queue must be empty and allocate from this resource");
+    }
+    const PmrQueueImage image = queue_snapshot_detail::read<Policy, PmrQueueImage>(
+        path, resource, queue_snapshot_detail::QueueKind::pointer_links, PmrQueue<T, Telemetry>::node_size());
+    queue.restore_image(image, resource.data());
+}
+
+template <class Policy, class T>
+void snapshot_queue(const std::filesystem::path& path, const BasicBlockMemoryResource<Policy>& resource,
+                    const CompactPmrQueue<T>& queue) {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy elements as raw bytes");
+    if (queue.resource() != &resource) {
+        throw std::invalid_argument("Queue does not allocate from this resource");
+    }
+    queue_snapshot_detail::write(path, resource, queue_snapshot_detail::QueueKind::offset_links,
+                                 CompactPmrQueue<T>::node_size(), queue.image());
+}
+
+template <class Policy, class T>
+void restore_queue(const std::filesystem::path& path, BasicBlockMemoryResource<Policy>& resource,
+                   CompactPmrQueue<T>& queue) {
+    static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy elements as raw bytes");
+    if (queue.resource() != &resource || !queue.empty()) {
+        throw std::invalid_argument("Queue must be empty and allocate from this resource");
+    }
+    queue.restore_image(queue_snapshot_detail::read<Policy, typename CompactPmrQueue<T>::Image>(
+        path, resource, queue_snapshot_detail::QueueKind::offset_links, CompactPmrQueue<T>::node_size()));
+}
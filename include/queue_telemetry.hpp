@@ -0,0 +1,296 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cheap monotonic tick source: the time-stamp counter where available, steady_clock otherwise.
+// The tick length is calibrated once against steady_clock on first use.
+class TscClock {
+public:
+    static std::uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    static double ns_per_tick() noexcept {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+    static std::uint64_t to_ns(std::uint64_t ticks) noexcept {
+        return static_cast<std::uint64_t>(static_cast<double>(ticks) * ns_per_tick());
+    }
+
+private:
+    static double calibrate() noexcept {
+        using clock = std::chrono::steady_clock;
+        const clock::time_point wall_start = clock::now();
+        const std::uint64_t tick_start = now();
+        while (clock::now() - wall_start < std::chrono::milliseconds(5)) {
+        }
+        const double wall_ns = std::chrono::duration<double, std::nano>(clock::now() - wall_start).count();
+        const std::uint64_t ticks = now() - tick_start;
+        return ticks == 0 ? 1.0 : wall_ns / static_cast<double>(ticks);
+    }
+};
+
+// Copy of a LogLinearHistogram taken at one moment.
+struct HistogramSnapshot {
+    std::uint64_t count{0};
+    std::uint64_t sum{0};
+    std::uint64_t max{0};
+    std::vector<std::uint64_t> buckets;
+
+    double mean() const noexcept {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    // Upper bound of the bucket holding the given quantile (0..1), capped by the maximum.
+    std::uint64_t value_at(double quantile) const noexcept;
+};
+
+// HDR-style histogram of unsigned values: exact below 16, then 16 linear sub-buckets per power
+// of two, i.e. a relative error under 6.25%. Recording is a relaxed atomic increment, so one
+// writer and any number of snapshot readers never block each other.
+class LogLinearHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    LogLinearHistogram() = default;
+
+    LogLinearHistogram(const LogLinearHistogram& other) noexcept {
+        copy_from(other);
+    }
+
+    LogLinearHistogram& operator=(const LogLinearHistogram& other) noexcept {
+        if (this != &other) {
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    static constexpr std::size_t bucket_of(std::uint64_t value) noexcept {
+        if (value < kSubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned magnitude = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const std::uint64_t sub = (value >> (magnitude - kSubBucketBits)) - kSubBuckets;
+        return (magnitude - kSubBucketBits + 1) * kSubBuckets + static_cast<std::size_t>(sub);
+    }
+
+    static constexpr std::uint64_t bucket_upper_bound(std::size_t bucket) noexcept {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        const unsigned shift = static_cast<unsigned>(bucket / kSubBuckets) - 1;
+        const std::uint64_t lower = (kSubBuckets + bucket % kSubBuckets) << shift;
+        return lower + ((std::uint64_t{1} << shift) - 1);
+    }
+
+    void record(std::uint64_t value) noexcept {
+        buckets_[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot result;
+        result.buckets.resize(kBucketCount);
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            result.count += result.buckets[i];
+        }
+        result.sum = sum_.load(std::memory_order_relaxed);
+        result.max = max_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset() noexcept {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+
+    void copy_from(const LogLinearHistogram& other) noexcept {
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            buckets_[i].store(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        count_.store(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        sum_.store(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        max_.store(other.max_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+};
+
+inline std::uint64_t HistogramSnapshot::value_at(double quantile) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+    const double clamped = quantile < 0.0 ? 0.0 : (quantile > 1.0 ? 1.0 : quantile);
+    std::uint64_t rank = static_cast<std::uint64_t>(clamped * static_cast<double>(count - 1)) + 1;
+    for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        if (buckets[bucket] >= rank) {
+            const std::uint64_t bound = LogLinearHistogram::bucket_upper_bound(bucket);
+            return bound < max ? bound : max;
+        }
+        rank -= buckets[bucket];
+    }
+    return max;
+}
+
+// Point-in-time view of a QueueTelemetry. Rates are averaged since construction or reset().
+struct QueueTelemetrySnapshot {
+    std::uint64_t pushes{0};
+    std::uint64_t pops{0};
+    std::size_t depth{0};
+    std::size_t max_depth{0};
+    double elapsed_seconds{0};
+    double push_rate{0};
+    double pop_rate{0};
+    HistogramSnapshot sojourn_ns;
+    HistogramSnapshot depth_samples;
+};
+
+// Telemetry policy for PmrQueue that compiles to nothing: its stamp is an empty type stored
+// with [[no_unique_address]] and every hook is an empty inline function.
+struct NoQueueTelemetry {
+    struct Stamp {};
+
+    static constexpr bool enabled = false;
+
+    Stamp on_push(std::size_t) noexcept { return {}; }
+    void on_pop(Stamp, std::size_t) noexcept {}
+    void on_transfer_in(std::size_t, std::size_t) noexcept {}
+    void on_transfer_out(std::size_t, std::size_t) noexcept {}
+};
+
+// Telemetry policy for PmrQueue. Every element is stamped with TscClock on emplace and its
+// sojourn time is recorded on pop; the depth after each operation is sampled into a second
+// histogram. The owning queue is the only writer, and snapshot() may be called from any thread.
+class QueueTelemetry {
+public:
+    using Stamp = std::uint64_t;
+
+    static constexpr bool enabled = true;
+
+    QueueTelemetry() noexcept : started_(TscClock::now()) {
+        static_cast<void>(TscClock::ns_per_tick());
+    }
+
+    QueueTelemetry(const QueueTelemetry& other) noexcept
+        : pushes_(other.pushes_.load(std::memory_order_relaxed)),
+          pops_(other.pops_.load(std::memory_order_relaxed)),
+          depth_(other.depth_.load(std::memory_order_relaxed)),
+          max_depth_(other.max_depth_.load(std::memory_order_relaxed)),
+          started_(other.started_.load(std::memory_order_relaxed)),
+          sojourn_(other.sojourn_),
+          depth_samples_(other.depth_samples_) {}
+
+    QueueTelemetry& operator=(const QueueTelemetry& other) noexcept {
+        if (this != &other) {
+            pushes_.store(other.pushes_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            pops_.store(other.pops_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            depth_.store(other.depth_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            max_depth_.store(other.max_depth_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            started_.store(other.started_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            sojourn_ = other.sojourn_;
+            depth_samples_ = other.depth_samples_;
+        }
+        return *this;
+    }
+
+    Stamp on_push(std::size_t depth) noexcept {
+        pushes_.fetch_add(1, std::memory_order_relaxed);
+        track_depth(depth);
+        return TscClock::now();
+    }
+
+    void on_pop(Stamp pushed_at, std::size_t depth) noexcept {
+        const std::uint64_t now = TscClock::now();
+        sojourn_.record(now > pushed_at ? TscClock::to_ns(now - pushed_at) : 0);
+        pops_.fetch_add(1, std::memory_order_relaxed);
+        track_depth(depth);
+    }
+
+    // Elements relinked by splice() keep their stamps and are counted as pushes and pops.
+    void on_transfer_in(std::size_t count, std::size_t depth) noexcept {
+        pushes_.fetch_add(count, std::memory_order_relaxed);
+        track_depth(depth);
+    }
+
+    void on_transfer_out(std::size_t count, std::size_t depth) noexcept {
+        pops_.fetch_add(count, std::memory_order_relaxed);
+        track_depth(depth);
+    }
+
+    QueueTelemetrySnapshot snapshot() const {
+        QueueTelemetrySnapshot result;
+        result.pushes = pushes_.load(std::memory_order_relaxed);
+        result.pops = pops_.load(std::memory_order_relaxed);
+        result.depth = depth_.load(std::memory_order_relaxed);
+        result.max_depth = max_depth_.load(std::memory_order_relaxed);
+        const std::uint64_t ticks = TscClock::now() - started_.load(std::memory_order_relaxed);
+        result.elapsed_seconds = static_cast<double>(TscClock::to_ns(ticks)) * 1e-9;
+        if (result.elapsed_seconds > 0) {
+            result.push_rate = static_cast<double>(result.pushes) / result.elapsed_seconds;
+            result.pop_rate = static_cast<double>(result.pops) / result.elapsed_seconds;
+        }
+        result.sojourn_ns = sojourn_.snapshot();
+        result.depth_samples = depth_samples_.snapshot();
+        return result;
+    }
+
+    // Clears counters and histograms; the current depth is kept.
+    void reset() noexcept {
+        pushes_.store(0, std::memory_order_relaxed);
+        pops_.store(0, std::memory_order_relaxed);
+        max_depth_.store(depth_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        started_.store(TscClock::now(), std::memory_order_relaxed);
+        sojourn_.reset();
+        depth_samples_.reset();
+    }
+
+private:
+    std::atomic<std::uint64_t> pushes_{0};
+    std::atomic<std::uint64_t> pops_{0};
+    std::atomic<std::size_t> depth_{0};
+    std::atomic<std::size_t> max_depth_{0};
+    std::atomic<std::uint64_t> started_{0};
+    LogLinearHistogram sojourn_;
+    LogLinearHistogram depth_samples_;
+
+    void track_depth(std::size_t depth) noexcept {
+        depth_.store(depth, std::memory_order_relaxed);
+        if (depth > max_depth_.load(std::memory_order_relaxed)) {
+            max_depth_.store(depth, std::memory_order_relaxed);
+        }
+        depth_samples_.record(depth);
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "shared_memory_resource.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// FIFO queue of trivially copyable records shared by processes that map the same region,
+// e.g. a SharedMemorySegment. The queue header, a robust process-shared mutex and a private
+// SharedBlockMemoryResource arena all live in the region, and nodes are linked by offsets from
+// the arena start, so every process may map it at a different address. The element count is
+// an atomic, so empty() can be polled without taking the lock.
+//
+// If a process dies while holding the queue lock, the next caller walks the chain from the
+// head, cuts it at the first link that leaves the arena or closes a loop, and rebuilds the
+// arena's block table in place from the surviving nodes, reclaiming anything the dead process
+// had allocated but not linked. Recovery allocates nothing, and one that fails is retried.
+// drain() hands an element to the consumer before unlinking it, so a consumer that crashes
+// mid-drain leaves that element queued for the next one.
+template <class T>
+class SharedMemoryQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "Shared records must be trivially copyable");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared atomics must be lock-free");
+
+public:
+    static constexpr std::uint64_t null_offset = UINT64_MAX;
+
+    SharedMemoryQueue(void* region, std::size_t region_bytes, SharedSegmentMode mode)
+        : header_(static_cast<Header*>(region)),
+          resource_(static_cast<std::byte*>(region) + header_bytes, checked_arena_bytes(region_bytes), mode,
+                    arena_blocks(region_bytes)) {
+        if (mode == SharedSegmentMode::create) {
+            header_ = ::new (region) Header{};
+            shared_memory_detail::init_robust_mutex(&header_->mutex);
+            header_->node_size = sizeof(Node);
+            header_->magic = kMagic;
+        } else if (header_->magic != kMagic || header_->node_size != sizeof(Node)) {
+            throw std::invalid_argument("Region does not hold a queue of this element type");
+        }
+        base_ = resource_.data();
+    }
+
+    SharedMemoryQueue(const SharedMemoryQueue&) = delete;
+    SharedMemoryQueue& operator=(const SharedMemoryQueue&) = delete;
+
+    // Region size needed for `count` elements with the default block table.
+    static constexpr std::size_t region_bytes_for(std::size_t count) noexcept {
+        return header_bytes + 4096 + count * (sizeof(Node) + sizeof(SharedBlockMemoryResource::Block) + 16);
+    }
+
+    bool try_push(const T& value) {
+        Guard guard(*this);
+        void* raw = resource_.try_allocate(sizeof(Node), alignof(Node));
+        if (raw == nullptr) {
+            return false;
+        }
+        Node* node = ::new (raw) Node{value, null_offset};
+        const std::uint64_t offset = offset_of(node);
+        if (header_->tail == null_offset) {
+            header_->head = offset;
+        } else {
+            node_at(header_->tail)->next = offset;
+        }
+        header_->tail = offset;
+        header_->size.fetch_add(1, std::memory_order_release);
+        ++header_->pushes;
+        return true;
+    }
+
+    void push(const T& value) {
+        if (!try_push(value)) {
+            throw std::bad_alloc();
+        }
+    }
+
+    bool try_pop(T& out) {
+        if (header_->size.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+        Guard guard(*this);
+        if (header_->head == null_offset) {
+            return false;
+        }
+        out = node_at(header_->head)->value;
+        unlink_head();
+        return true;
+    }
+
+    // Passes every queued element to `consumer` under one lock acquisition and returns how many.
+    template <class Consumer>
+    std::size_t drain(Consumer&& consumer) {
+        if (header_->size.load(std::memory_order_acquire) == 0) {
+            return 0;
+        }
+        Guard guard(*this);
+        std::size_t drained = 0;
+        while (header_->head != null_offset) {
+            consumer(static_cast<const T&>(node_at(header_->head)->value));
+            unlink_head();
+            ++drained;
+        }
+        return drained;
+    }
+
+    std::size_t size() const noexcept { return header_->size.load(std::memory_order_acquire); }
+    bool empty() const noexcept { return size() == 0; }
+
+    std::uint64_t pushes() const {
+        Guard guard(*this);
+        return header_->pushes;
+    }
+
+    std::uint64_t pops() const {
+        Guard guard(*this);
+        return header_->pops;
+    }
+
+    // Times the queue was recovered after a peer died holding its lock.
+    std::uint64_t recoveries() const {
+        Guard guard(*this);
+        return header_->recoveries;
+    }
+
+    SharedBlockMemoryResource& resource() noexcept { return resource_; }
+
+private:
+    static constexpr std::uint64_t kMagic = 0x504d52'534851'3031ull;
+
+    struct Node {
+        T value;
+        std::uint64_t next;
+    };
+
+    struct Header {
+        std::uint64_t magic{0};
+        std::uint64_t node_size{0};
+        std::uint64_t head{null_offset};
+        std::uint64_t tail{null_offset};
+        std::atomic<std::uint64_t> size{0};
+        std::uint64_t pushes{0};
+        std::uint64_t pops{0};
+        std::uint64_t recoveries{0};
+        // Set while a recovery is owed, so one that fails is retried by the next caller.
+        std::uint64_t recovery_pending{0};
+        pthread_mutex_t mutex;
+    };
+
+    static constexpr std::size_t header_bytes =
+        (sizeof(Header) + SharedBlockMemoryResource::arena_alignment - 1) / SharedBlockMemoryResource::arena_alignment *
+        SharedBlockMemoryResource::arena_alignment;
+
+    class Guard {
+    public:
+        // The mutex is marked consistent before the repair, so an exception from recover() can
+        // never leave it unrecoverable for every process mapping the region.
+        explicit Guard(const SharedMemoryQueue& queue) : lock_(&queue.header_->mutex) {
+            Header& header = *queue.header_;
+            if (lock_.owner_died()) {
+                header.recovery_pending = 1;
+                lock_.mark_consistent();
+            }
+            if (header.recovery_pending != 0) {
+                const_cast<SharedMemoryQueue&>(queue).recover();
+                header.recovery_pending = 0;
+            }
+        }
+
+    private:
+        shared_memory_detail::RobustMutexGuard lock_;
+    };
+
+    Header* header_;
+    SharedBlockMemoryResource resource_;
+    std::byte* base_{nullptr};
+
+    static std::size_t checked_arena_bytes(std::size_t region_bytes) {
+        if (region_bytes <= header_bytes) {
+            throw std::invalid_argument("Region is too small for the queue header");
+        }
+        return region_bytes - header_bytes;
+    }
+
+    // One table entry per node that could fit in the arena.
+    static std::size_t arena_blocks(std::size_t region_bytes) noexcept {
+        return region_bytes / (sizeof(Node) + sizeof(SharedBlockMemoryResource::Block)) + 1;
+    }
+
+    Node* node_at(std::uint64_t offset) const noexcept {
+        return reinterpret_cast<Node*>(base_ + offset);
+    }
+
+    std::uint64_t offset_of(const Node* node) const noexcept {
+        return static_cast<std::uint64_t>(reinterpret_cast<const std::byte*>(node) - base_);
+    }
+
+    void unlink_head() {
+        Node* node = node_at(header_->head);
+        header_->head = node->next;
+        if (header_->head == null_offset) {
+            header_->tail = null_offset;
+        }
+        header_->size.fetch_sub(1, std::memory_order_release);
+        ++header_->pops;
+        resource_.deallocate(node, sizeof(Node), alignof(Node));
+    }
+
+    bool valid_node_offset(std::uint64_t offset) const noexcept {
+        return offset % alignof(Node) == 0 && offset <= resource_.capacity() &&
+               resource_.capacity() - offset >= sizeof(Node);
+    }
+
+    std::uint64_t next_of(std::uint64_t offset) const noexcept { return node_at(offset)->next; }
+
+    void cut_after(std::uint64_t previous) noexcept {
+        if (previous == null_offset) {
+            header_->head = null_offset;
+        } else {
+            node_at(previous)->next = null_offset;
+        }
+    }
+
+    // Cuts the chain at the first link that leaves the arena, then at the link that closes a
+    // loop. A chain with more links than there are node positions must loop; the loop is found
+    // with Floyd's two pointers, so no per-node state is needed.
+    void cut_chain() noexcept {
+        const std::uint64_t positions = resource_.capacity() / alignof(Node) + 1;
+        std::uint64_t previous = null_offset;
+        std::uint64_t current = header_->head;
+        for (std::uint64_t steps = 0; current != null_offset && steps <= positions; ++steps) {
+            if (!valid_node_offset(current)) {
+                cut_after(previous);
+                return;
+            }
+            previous = current;
+            current = next_of(current);
+        }
+        if (current == null_offset) {
+            return;
+        }
+        std::uint64_t slow = header_->head;
+        std::uint64_t fast = header_->head;
+        do {
+            slow = next_of(slow);
+            fast = next_of(next_of(fast));
+        } while (slow != fast);
+        slow = header_->head;
+        while (slow != fast) {
+            slow = next_of(slow);
+            fast = next_of(fast);
+        }
+        std::uint64_t last = slow;
+        while (next_of(last) != slow) {
+            last = next_of(last);
+        }
+        node_at(last)->next = null_offset;
+    }
+
+    // Rebuilds the arena's table from the surviving chain in place; allocates nothing.
+    void recover() {
+        cut_chain();
+        std::uint64_t previous = null_offset;
+        std::uint64_t current = header_->head;
+        const std::size_t live = resource_.rebuild_with([&](SharedBlockMemoryResource::Block& block) {
+            if (current == null_offset) {
+                return false;
+            }
+            block = SharedBlockMemoryResource::Block{current, sizeof(Node)};
+            previous = current;
+            current = next_of(current);
+            return true;
+        });
+        if (current != null_offset) {
+            // More nodes than table entries: keep the ones the table could describe.
+            cut_after(previous);
+        }
+        header_->tail = previous;
+        header_->size.store(live, std::memory_order_release);
+        ++header_->recoveries;
+    }
+};
@@ -0,0 +1,358 @@
+#pragma once
+
+#include "memory_resource.hpp"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+// POSIX-only building blocks for memory shared between processes.
+
+enum class SharedSegmentMode { create, attach };
+
+// Named POSIX shared-memory object mapped into this process. The creating side unlinks the
+// name on destruction; peers that attached only unmap it.
+class SharedMemorySegment {
+public:
+    // `size` is required when creating and ignored when attaching.
+    SharedMemorySegment(std::string name, SharedSegmentMode mode, std::size_t size = 0)
+        : name_(std::move(name)), owner_(mode == SharedSegmentMode::create) {
+        const int flags = owner_ ? O_CREAT | O_EXCL | O_RDWR : O_RDWR;
+        const int fd = ::shm_open(name_.c_str(), flags, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name_);
+        }
+        if (owner_ && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            const int error = errno;
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::system_error(error, std::generic_category(), "ftruncate " + name_);
+        }
+        if (!owner_) {
+            struct stat info {};
+            if (::fstat(fd, &info) != 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat " + name_);
+            }
+            size = static_cast<std::size_t>(info.st_size);
+        }
+        void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            if (owner_) {
+                ::shm_unlink(name_.c_str());
+            }
+            throw std::system_error(error, std::generic_category(), "mmap " + name_);
+        }
+        data_ = static_cast<std::byte*>(mapping);
+        size_ = size;
+    }
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    ~SharedMemorySegment() {
+        ::munmap(data_, size_);
+        if (owner_) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    std::byte* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    const std::string& name() const noexcept { return name_; }
+    bool owner() const noexcept { return owner_; }
+
+private:
+    std::string name_;
+    bool owner_;
+    std::byte* data_{nullptr};
+    std::size_t size_{0};
+};
+
+namespace shared_memory_detail {
+
+inline void init_robust_mutex(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    const int result = pthread_mutex_init(mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    if (result != 0) {
+        throw std::system_error(result, std::generic_category(), "pthread_mutex_init");
+    }
+}
+
+// Holds a process-shared robust mutex. If the previous owner died while holding it,
+// owner_died() is true and the caller must repair the protected state and call
+// mark_consistent() before the guard unlocks, or the mutex becomes unusable.
+class RobustMutexGuard {
+public:
+    explicit RobustMutexGuard(pthread_mutex_t* mutex) : mutex_(mutex) {
+        const int result = pthread_mutex_lock(mutex_);
+        if (result == EOWNERDEAD) {
+            owner_died_ = true;
+        } else if (result != 0) {
+            throw std::system_error(result, std::generic_category(), "pthread_mutex_lock");
+        }
+    }
+
+    RobustMutexGuard(const RobustMutexGuard&) = delete;
+    RobustMutexGuard& operator=(const RobustMutexGuard&) = delete;
+
+    ~RobustMutexGuard() {
+        pthread_mutex_unlock(mutex_);
+    }
+
+    bool owner_died() const noexcept { return owner_died_; }
+
+    void mark_consistent() noexcept {
+        pthread_mutex_consistent(mutex_);
+        owner_died_ = false;
+    }
+
+private:
+    pthread_mutex_t* mutex_;
+    bool owner_died_{false};
+};
+
+}  // namespace shared_memory_detail
+
+// First-fit resource like CustomBlockMemoryResource, but the block table, counters and a
+// robust process-shared mutex live at the start of the given region, so every process that
+// maps it sees one allocator. Offsets are relative to data(), which differs per process.
+// When a process dies holding the lock, the next caller drops table entries that are out of
+// bounds or overlap (a half-done insert or erase leaves a duplicate) and continues; owners
+// that know the exact set of live blocks can call rebuild() instead.
+class SharedBlockMemoryResource : public NothrowMemoryResource {
+public:
+    struct Block {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    static constexpr std::size_t arena_alignment = 64;
+
+    // Formats the region when creating, validates it when attaching. `max_blocks` bounds the
+    // in-segment block table; 0 picks one block per 64 bytes of region.
+    SharedBlockMemoryResource(void* region, std::size_t region_bytes, SharedSegmentMode mode,
+                              std::size_t max_blocks = 0) {
+        if (region == nullptr || reinterpret_cast<std::uintptr_t>(region) % arena_alignment != 0) {
+            throw std::invalid_argument("Region must be non-null and 64-byte aligned");
+        }
+        header_ = static_cast<Header*>(region);
+        if (mode == SharedSegmentMode::create) {
+            if (max_blocks == 0) {
+                max_blocks = region_bytes / arena_alignment;
+            }
+            const std::size_t arena_offset = round_up(sizeof(Header) + max_blocks * sizeof(Block), arena_alignment);
+            if (max_blocks == 0 || arena_offset >= region_bytes) {
+                throw std::invalid_argument("Region is too small for the block table");
+            }
+            header_ = ::new (region) Header{};
+            header_->arena_offset = arena_offset;
+            header_->arena_bytes = region_bytes - arena_offset;
+            header_->max_blocks = max_blocks;
+            shared_memory_detail::init_robust_mutex(&header_->mutex);
+            header_->magic = kMagic;
+        } else if (header_->magic != kMagic || header_->arena_offset + header_->arena_bytes > region_bytes) {
+            throw std::invalid_argument("Region does not hold a shared block resource");
+        }
+        blocks_ = reinterpret_cast<Block*>(static_cast<std::byte*>(region) + sizeof(Header));
+        arena_ = static_cast<std::byte*>(region) + header_->arena_offset;
+    }
+
+    SharedBlockMemoryResource(const SharedBlockMemoryResource&) = delete;
+    SharedBlockMemoryResource& operator=(const SharedBlockMemoryResource&) = delete;
+
+    std::size_t capacity() const noexcept { return header_->arena_bytes; }
+    std::size_t max_blocks() const noexcept { return header_->max_blocks; }
+    std::byte* data() noexcept { return arena_; }
+    const std::byte* data() const noexcept { return arena_; }
+
+    std::size_t used_bytes() const {
+        Guard guard(*this);
+        return header_->used_bytes;
+    }
+
+    std::size_t block_count() const {
+        Guard guard(*this);
+        return header_->block_count;
+    }
+
+    // Times the table was repaired after a peer died holding the lock.
+    std::size_t repairs() const {
+        Guard guard(*this);
+        return header_->repairs;
+    }
+
+    // Replaces the block table with `live`, which must be sorted by offset and fit the table.
+    void rebuild(std::span<const Block> live) {
+        if (live.size() > header_->max_blocks) {
+            throw std::invalid_argument("Too many live blocks for the block table");
+        }
+        std::size_t index = 0;
+        rebuild_with([&](Block& block) {
+            if (index == live.size()) {
+                return false;
+            }
+            block = live[index++];
+            return true;
+        });
+    }
+
+    // Replaces the block table with the blocks `next_block(Block&)` yields until it returns
+    // false, at most max_blocks() of them, and returns how many it took. The table is filled and
+    // sorted in place without allocating, so owners can call this while repairing their own state
+    // under a robust mutex.
+    template <class NextBlock>
+    std::size_t rebuild_with(NextBlock&& next_block) {
+        Guard guard(*this);
+        std::uint64_t count = 0;
+        std::uint64_t used = 0;
+        while (count < header_->max_blocks && next_block(blocks_[count])) {
+            used += blocks_[count].size;
+            ++count;
+        }
+        std::sort(blocks_, blocks_ + count, [](const Block& lhs, const Block& rhs) { return lhs.offset < rhs.offset; });
+        header_->block_count = count;
+        header_->used_bytes = used;
+        return static_cast<std::size_t>(count);
+    }
+
+private:
+    static constexpr std::uint64_t kMagic = 0x504d52'53484d'3031ull;
+
+    struct Header {
+        std::uint64_t magic{0};
+        std::uint64_t arena_offset{0};
+        std::uint64_t arena_bytes{0};
+        std::uint64_t max_blocks{0};
+        std::uint64_t block_count{0};
+        std::uint64_t used_bytes{0};
+        std::uint64_t repairs{0};
+        pthread_mutex_t mutex;
+    };
+
+    // Locks the in-segment mutex and repairs the table if its previous owner died.
+    class Guard {
+    public:
+        explicit Guard(const SharedBlockMemoryResource& resource) : lock_(&resource.header_->mutex) {
+            if (lock_.owner_died()) {
+                resource.repair();
+                lock_.mark_consistent();
+            }
+        }
+
+    private:
+        shared_memory_detail::RobustMutexGuard lock_;
+    };
+
+    Header* header_{nullptr};
+    Block* blocks_{nullptr};
+    std::byte* arena_{nullptr};
+
+    static std::size_t round_up(std::size_t value, std::size_t alignment) noexcept {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void repair() const noexcept {
+        const std::uint64_t count = header_->block_count < header_->max_blocks ? header_->block_count : header_->max_blocks;
+        std::uint64_t kept = 0;
+        std::uint64_t used = 0;
+        std::uint64_t previous_end = 0;
+        for (std::uint64_t index = 0; index < count; ++index) {
+            const Block block = blocks_[index];
+            if (block.size == 0 || block.offset < previous_end || block.offset + block.size > header_->arena_bytes) {
+                continue;
+            }
+            blocks_[kept++] = block;
+            used += block.size;
+            previous_end = block.offset + block.size;
+        }
+        header_->block_count = kept;
+        header_->used_bytes = used;
+        ++header_->repairs;
+    }
+
+    void* do_try_allocate(std::size_t bytes, std::size_t alignment) noexcept override {
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        const std::size_t required_alignment = alignment == 0 ? alignof(std::max_align_t) : alignment;
+        if (required_alignment > arena_alignment) {
+            return nullptr;
+        }
+        try {
+            Guard guard(*this);
+            const std::uint64_t count = header_->block_count;
+            if (count == header_->max_blocks) {
+                return nullptr;
+            }
+            std::uint64_t gap_begin = 0;
+            for (std::uint64_t index = 0; index <= count; ++index) {
+                const std::uint64_t offset = round_up(gap_begin, required_alignment);
+                const std::uint64_t gap_end = index < count ? blocks_[index].offset : header_->arena_bytes;
+                if (offset <= gap_end && gap_end - offset >= bytes) {
+                    // Grow the count first so a crash mid-shift leaves a duplicate, not a lost entry.
+                    header_->block_count = count + 1;
+                    for (std::uint64_t move = count; move > index; --move) {
+                        blocks_[move] = blocks_[move - 1];
+                    }
+                    blocks_[index] = Block{offset, bytes};
+                    header_->used_bytes += bytes;
+                    return arena_ + offset;
+                }
+                if (index < count) {
+                    gap_begin = blocks_[index].offset + blocks_[index].size;
+                }
+            }
+        } catch (const std::system_error&) {
+        }
+        return nullptr;
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t) override {
+        if (ptr == nullptr) {
+            return;
+        }
+        const auto byte_ptr = static_cast<std::byte*>(ptr);
+        if (byte_ptr < arena_ || byte_ptr >= arena_ + header_->arena_bytes) {
+            throw std::logic_error("Pointer does not belong to this resource");
+        }
+        const auto offset = static_cast<std::uint64_t>(byte_ptr - arena_);
+        Guard guard(*this);
+        const std::uint64_t count = header_->block_count;
+        for (std::uint64_t index = 0; index < count; ++index) {
+            if (blocks_[index].offset == offset) {
+                header_->used_bytes -= blocks_[index].size;
+                for (std::uint64_t move = index; move + 1 < count; ++move) {
+                    blocks_[move] = blocks_[move + 1];
+                }
+                header_->block_count = count - 1;
+                return;
+            }
+        }
+        throw std::logic_error("Attempt to deallocate unmanaged block");
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
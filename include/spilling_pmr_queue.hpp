@@ -0,0 +1,307 @@
+#pragma once
+
+#include "pmr_queue.hpp"
+#include "queue_serializer.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SpillOptions {
+    // Required. Created if missing; several queues may share it, since each one names its
+    // files with the process id and a per-process instance number.
+    std::filesystem::path directory;
+    // Elements per segment; a segment is spilled and reloaded as a whole.
+    std::size_t segment_elements{1024};
+    // Share of the resource capacity above which middle segments go to disk.
+    double spill_watermark{0.75};
+    // Spilled segments read ahead of the consumer.
+    std::size_t prefetch_segments{1};
+};
+
+struct SpillStats {
+    std::size_t segments_spilled{0};
+    std::size_t segments_loaded{0};
+    std::size_t prefetch_hits{0};
+    std::size_t bytes_written{0};
+    std::size_t bytes_read{0};
+};
+
+// Resource that reports how full it is, like CustomBlockMemoryResource.
+template <class Resource>
+concept MeasurableMemoryResource = std::derived_from<Resource, std::pmr::memory_resource> && requires(const Resource& resource) {
+    { resource.used_bytes() } -> std::convertible_to<std::size_t>;
+    { resource.capacity() } -> std::convertible_to<std::size_t>;
+};
+
+// FIFO queue that overflows to disk instead of failing with std::bad_alloc. Elements are grouped
+// into segments of PmrQueue<T> on a bounded resource. The head segment (being consumed) and
+// the tail segment (being filled) always stay in memory; once the resource passes the
+// watermark, or an allocation fails, the newest middle segments are serialized with
+// `Serializer` into files under `directory` and their nodes are released. Segment files are
+// read back on a background thread before the consumer reaches them and deserialized on the
+// consumer's thread when their segment becomes the head. Like PmrQueue, the queue itself is
+// not synchronized.
+template <class T, class Serializer = QueueSerializer<T>>
+class SpillingPmrQueue {
+public:
+    using value_type = T;
+
+    template <MeasurableMemoryResource Resource>
+    SpillingPmrQueue(Resource& resource, SpillOptions options)
+        : resource_(&resource),
+          fill_ratio_([&resource] {
+              return static_cast<double>(resource.used_bytes()) / static_cast<double>(resource.capacity());
+          }),
+          options_(std::move(options)) {
+        if (options_.segment_elements == 0) {
+            throw std::invalid_argument("Segments must hold at least one element");
+        }
+        if (!(options_.spill_watermark > 0.0 && options_.spill_watermark <= 1.0)) {
+            throw std::invalid_argument("Spill watermark must be in (0, 1]");
+        }
+        if (options_.directory.empty()) {
+            throw std::invalid_argument("Spill directory must be set");
+        }
+        std::filesystem::create_directories(options_.directory);
+        segments_.push_back(make_segment());
+    }
+
+    SpillingPmrQueue(const SpillingPmrQueue&) = delete;
+    SpillingPmrQueue& operator=(const SpillingPmrQueue&) = delete;
+
+    ~SpillingPmrQueue() {
+        for (Segment& segment : segments_) {
+            if (segment.prefetch.valid()) {
+                segment.prefetch.wait();
+            }
+            if (segment.spilled) {
+                std::error_code ignored;
+                std::filesystem::remove(path_of(segment), ignored);
+            }
+        }
+    }
+
+    // Only a failed node allocation forces a spill and a retry, since the arguments are still
+    // untouched then; exceptions from T's constructor propagate as they are.
+    template <class... Args>
+    void emplace(Args&&... args) {
+        if (over_watermark()) {
+            spill_middle_segments(false);
+        }
+        if (segments_.back().items.size() >= options_.segment_elements) {
+            segments_.push_back(make_segment());
+        }
+        if (!segments_.back().items.try_emplace(std::forward<Args>(args)...)) {
+            if (!spill_middle_segments(true)) {
+                throw std::bad_alloc();
+            }
+            segments_.back().items.emplace(std::forward<Args>(args)...);
+        }
+        ++size_;
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // Like front(), throws std::bad_alloc if a spilled head cannot be loaded; the queue is left
+    // unchanged and the load is retried on the next call.
+    void pop() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        load_head();
+        segments_.front().items.pop();
+        --size_;
+        advance_head();
+    }
+
+    T& front() {
+        if (empty()) {
+            throw std::out_of_range("Queue is empty");
+        }
+        load_head();
+        return segments_.front().items.front();
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t size() const noexcept { return size_; }
+
+    std::size_t segment_count() const noexcept { return segments_.size(); }
+
+    std::size_t spilled_segments() const noexcept {
+        std::size_t count = 0;
+        for (const Segment& segment : segments_) {
+            count += segment.spilled ? 1 : 0;
+        }
+        return count;
+    }
+
+    const SpillStats& stats() const noexcept { return stats_; }
+    std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
+private:
+    struct Segment {
+        std::uint64_t id;
+        PmrQueue<T> items;
+        bool spilled{false};
+        std::future<std::vector<std::byte>> prefetch;
+    };
+
+    std::pmr::memory_resource* resource_;
+    std::function<double()> fill_ratio_;
+    SpillOptions options_;
+    std::deque<Segment> segments_;
+    std::size_t size_{0};
+    std::uint64_t next_segment_id_{0};
+    std::string file_prefix_{unique_file_prefix()};
+    SpillStats stats_{};
+
+    static std::string unique_file_prefix() {
+        static std::atomic<std::uint64_t> instances{0};
+        return "spill-" + std::to_string(::getpid()) + "-" + std::to_string(instances.fetch_add(1)) + "-segment-";
+    }
+
+    Segment make_segment() {
+        return Segment{next_segment_id_++, PmrQueue<T>(resource_), false, {}};
+    }
+
+    bool over_watermark() const {
+        return fill_ratio_() > options_.spill_watermark;
+    }
+
+    std::filesystem::path path_of(const Segment& segment) const {
+        return options_.directory / (file_prefix_ + std::to_string(segment.id) + ".bin");
+    }
+
+    // Spills resident segments between head and tail, newest first, until the resource is back
+    // under the watermark. `force` also seals the tail so it can go, and spills at least one
+    // segment if any is eligible. Returns whether anything was spilled.
+    bool spill_middle_segments(bool force) {
+        if (force && segments_.size() >= 2 && !segments_.back().items.empty()) {
+            segments_.push_back(make_segment());
+        }
+        bool spilled = false;
+        for (std::size_t index = segments_.size() - 1; index-- > 1;) {
+            if ((spilled || !force) && !over_watermark()) {
+                break;
+            }
+            Segment& segment = segments_[index];
+            if (!segment.spilled && !segment.items.empty()) {
+                spill(segment);
+                spilled = true;
+            }
+        }
+        return spilled;
+    }
+
+    void spill(Segment& segment) {
+        std::vector<std::byte> bytes;
+        QueueSerializer<std::uint64_t>::write(segment.items.size(), bytes);
+        for (const T& value : segment.items) {
+            Serializer::write(value, bytes);
+        }
+        std::ofstream out(path_of(segment), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            throw std::runtime_error("Cannot write spill segment " + path_of(segment).string());
+        }
+
+        segment.spilled = true;
+        while (!segment.items.empty()) {
+            segment.items.pop();
+        }
+        ++stats_.segments_spilled;
+        stats_.bytes_written += bytes.size();
+    }
+
+    static std::vector<std::byte> read_file(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<std::byte> bytes(static_cast<std::size_t>(std::filesystem::file_size(path)));
+        in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!in) {
+            throw std::runtime_error("Cannot read spill segment " + path.string());
+        }
+        return bytes;
+    }
+
+    // Deserializes into a separate queue first, so a failure leaves the segment spilled and its
+    // file in place.
+    void load(Segment& segment) {
+        std::vector<std::byte> bytes;
+        if (segment.prefetch.valid()) {
+            if (segment.prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                ++stats_.prefetch_hits;
+            }
+            bytes = segment.prefetch.get();
+        } else {
+            bytes = read_file(path_of(segment));
+        }
+
+        std::span<const std::byte> in(bytes);
+        const std::pmr::polymorphic_allocator<> alloc(resource_);
+        const std::uint64_t count = QueueSerializer<std::uint64_t>::read(in, alloc);
+        PmrQueue<T> loaded(resource_);
+        for (std::uint64_t index = 0; index < count; ++index) {
+            loaded.push(Serializer::read(in, alloc));
+        }
+        segment.items.splice(loaded);
+        std::error_code ignored;
+        std::filesystem::remove(path_of(segment), ignored);
+        segment.spilled = false;
+        ++stats_.segments_loaded;
+        stats_.bytes_read += bytes.size();
+    }
+
+    // Brings a spilled head back into memory, making room the same way emplace() does.
+    void load_head() {
+        Segment& head = segments_.front();
+        if (!head.spilled) {
+            return;
+        }
+        if (over_watermark()) {
+            spill_middle_segments(false);
+        }
+        try {
+            load(head);
+        } catch (const std::bad_alloc&) {
+            if (!spill_middle_segments(true)) {
+                throw;
+            }
+            load(head);
+        }
+    }
+
+    // Drops the exhausted head and starts read-ahead of the next spilled segments, the new
+    // head included; that one is loaded by the next front() or pop().
+    void advance_head() {
+        if (!segments_.front().items.empty() || segments_.size() == 1) {
+            return;
+        }
+        segments_.pop_front();
+        const std::size_t last = std::min(segments_.size(), options_.prefetch_segments + 1);
+        for (std::size_t index = 0; index < last; ++index) {
+            Segment& segment = segments_[index];
+            if (segment.spilled && !segment.prefetch.valid()) {
+                segment.prefetch = std::async(std::launch::async, &SpillingPmrQueue::read_file, path_of(segment));
+            }
+        }
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "exception_config.hpp"
+#include "memory_resource.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+
+// First-fit memory resource whose buffer and block table live inside the object, so it can
+// be placed on the stack or in static storage without touching the heap. The default table
+// holds one block per 64 bytes of buffer, which keeps it at a quarter of the buffer's size.
+template <std::size_t Capacity,
+          std::size_t Alignment = 64,
+          std::size_t MaxBlocks = (Capacity / 64 > 0 ? Capacity / 64 : 1)>
+class StaticBlockMemoryResource : public std::pmr::memory_resource {
+    static_assert(Capacity > 0, "Capacity must be greater than zero");
+    static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+    static_assert(Capacity % Alignment == 0, "Capacity must be a multiple of the alignment");
+    static_assert(MaxBlocks > 0, "Block table must hold at least one block");
+    static_assert(MaxBlocks <= Capacity, "Block table cannot exceed one block per byte");
+
+public:
+    StaticBlockMemoryResource() = default;
+
+    StaticBlockMemoryResource(const StaticBlockMemoryResource&) = delete;
+    StaticBlockMemoryResource& operator=(const StaticBlockMemoryResource&) = delete;
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+    static constexpr std::size_t max_blocks() noexcept { return MaxBlocks; }
+
+    std::size_t block_count() const noexcept { return block_count_; }
+    std::byte* data() noexcept { return buffer_; }
+    const std::byte* data() const noexcept { return buffer_; }
+
+private:
+    using Block = block_placement::Block;
+
+    alignas(Alignment) std::byte buffer_[Capacity];
+    std::array<Block, MaxBlocks> blocks_{};
+    std::size_t block_count_{0};
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes == 0) {
+            bytes = 1;
+        }
+        const std::size_t required_alignment = alignment == 0 ? alignof(std::max_align_t) : alignment;
+        if (required_alignment > Alignment || block_count_ == MaxBlocks) {
+            pmr_queue_throw(std::bad_alloc());
+        }
+
+        const block_placement::Placement placement = block_placement::FirstFit{}.find(
+            std::span<const Block>(blocks_.data(), block_count_), Capacity, bytes, required_alignment);
+        if (!placement.found()) {
+            pmr_queue_throw(std::bad_alloc());
+        }
+        return commit_block(placement.index, placement.offset, bytes);
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t) override {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        const auto byte_ptr = static_cast<std::byte*>(ptr);
+        if (byte_ptr < buffer_ || byte_ptr >= buffer_ + Capacity) {
+            pmr_queue_throw(std::logic_error("Pointer does not belong to this resource"));
+        }
+
+        const std::size_t offset = static_cast<std::size_t>(byte_ptr - buffer_);
+        const auto first = blocks_.begin();
+        const auto last = first + static_cast<std::ptrdiff_t>(block_count_);
+        const auto it = std::lower_bound(first, last, offset, [](const Block& lhs, std::size_t rhs) {
+            return lhs.offset < rhs;
+        });
+        if (it == last || it->offset != offset) {
+            pmr_queue_throw(std::logic_error("Attempt to deallocate unmanaged block"));
+        }
+        std::move(it + 1, last, it);
+        --block_count_;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void* commit_block(std::size_t index, std::size_t offset, std::size_t size) {
+        const auto position = blocks_.begin() + static_cast<std::ptrdiff_t>(index);
+        std::move_backward(position, blocks_.begin() + static_cast<std::ptrdiff_t>(block_count_),
+                           blocks_.begin() + static_cast<std::ptrdiff_t>(block_count_ + 1));
+        *position = Block{offset, size};
+        ++block_count_;
+        return buffer_ + offset;
+    }
+};
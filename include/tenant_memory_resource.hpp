@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+
+// Per-tenant counters kept by TenantMemoryResource.
+struct TenantUsage {
+    std::size_t bytes_in_use{0};
+    std::size_t peak_bytes{0};
+    std::size_t allocations{0};
+    std::size_t deallocations{0};
+    std::size_t rejected{0};
+    std::size_t soft_limit_crossings{0};
+};
+
+// Tenant-scoped view of a shared parent resource. Allocations are forwarded to the parent
+// (usually a CustomBlockMemoryResource shared by many tenants) as long as the tenant stays
+// under its hard quota; beyond it the tenant alone gets std::bad_alloc. Crossing the soft
+// limit is only recorded, so producers can throttle before the hard quota is hit.
+// Like the parent, the view is not synchronized.
+class TenantMemoryResource : public std::pmr::memory_resource {
+public:
+    TenantMemoryResource(std::pmr::memory_resource* parent, std::size_t hard_quota)
+        : TenantMemoryResource(parent, hard_quota, hard_quota) {}
+
+    TenantMemoryResource(std::pmr::memory_resource* parent, std::size_t hard_quota, std::size_t soft_limit)
+        : parent_(parent), hard_quota_(hard_quota), soft_limit_(soft_limit) {
+        if (parent == nullptr) {
+            throw std::invalid_argument("Parent resource must not be null");
+        }
+        if (soft_limit > hard_quota) {
+            throw std::invalid_argument("Soft limit must not exceed the hard quota");
+        }
+    }
+
+    TenantMemoryResource(const TenantMemoryResource&) = delete;
+    TenantMemoryResource& operator=(const TenantMemoryResource&) = delete;
+
+    std::pmr::memory_resource* parent() const noexcept { return parent_; }
+    std::size_t hard_quota() const noexcept { return hard_quota_; }
+    std::size_t soft_limit() const noexcept { return soft_limit_; }
+    const TenantUsage& usage() const noexcept { return usage_; }
+
+    std::size_t remaining() const noexcept { return hard_quota_ - usage_.bytes_in_use; }
+    bool over_soft_limit() const noexcept { return usage_.bytes_in_use > soft_limit_; }
+
+private:
+    std::pmr::memory_resource* parent_;
+    std::size_t hard_quota_;
+    std::size_t soft_limit_;
+    TenantUsage usage_;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes > remaining()) {
+            ++usage_.rejected;
+            throw std::bad_alloc();
+        }
+        void* ptr = parent_->allocate(bytes, alignment);
+
+        const bool was_over_soft_limit = over_soft_limit();
+        usage_.bytes_in_use += bytes;
+        usage_.peak_bytes = std::max(usage_.peak_bytes, usage_.bytes_in_use);
+        ++usage_.allocations;
+        if (!was_over_soft_limit && over_soft_limit()) {
+            ++usage_.soft_limit_crossings;
+        }
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+        parent_->deallocate(ptr, bytes, alignment);
+        usage_.bytes_in_use -= bytes;
+        ++usage_.deallocations;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
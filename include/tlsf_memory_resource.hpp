@@ -0,0 +1,321 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+
+// Two-Level Segregated Fit allocator over a fixed, aligned buffer. Free blocks are kept in
+// size-class lists indexed by a first-level (power of two) and second-level (linear split)
+// bitmap pair, so finding a fitting block, splitting it and coalescing on free are all O(1)
+// regardless of how many blocks are live. Every block starts with a 16-byte header holding
+// its size, two flags and a link to the physically previous block.
+class TlsfMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit TlsfMemoryResource(std::size_t capacity_bytes, std::size_t buffer_alignment = 64)
+        : capacity_(capacity_bytes), buffer_alignment_(buffer_alignment) {
+        if (!std::has_single_bit(buffer_alignment) || buffer_alignment < kAlign) {
+            throw std::invalid_argument("Alignment must be a power of two of at least 16");
+        }
+        if (capacity_bytes < 2 * sizeof(Header) + kMinPayload) {
+            throw std::invalid_argument("Capacity is too small for a single block");
+        }
+        // One free block spanning the buffer, followed by a used zero-sized sentinel. A payload
+        // of 2^kFlMax would already map past the last first-level class.
+        const std::size_t payload = (capacity_bytes - 2 * sizeof(Header)) / kAlign * kAlign;
+        if (payload >= kMaxBlockSize) {
+            throw std::invalid_argument("Capacity exceeds the largest size class");
+        }
+        buffer_ = static_cast<std::byte*>(::operator new(capacity_bytes, std::align_val_t(buffer_alignment_)));
+
+        Header* first = ::new (static_cast<void*>(buffer_)) Header{nullptr, payload};
+        Header* sentinel = ::new (static_cast<void*>(next_physical(first))) Header{first, 0};
+        sentinel->set_used();
+        first->set_free();
+        insert_free(first);
+    }
+
+    TlsfMemoryResource(const TlsfMemoryResource&) = delete;
+    TlsfMemoryResource& operator=(const TlsfMemoryResource&) = delete;
+
+    ~TlsfMemoryResource() override {
+        ::operator delete(buffer_, std::align_val_t(buffer_alignment_));
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    std::byte* data() noexcept { return buffer_; }
+    const std::byte* data() const noexcept { return buffer_; }
+
+    // Bytes that callers cannot currently get: used payloads plus all block headers.
+    std::size_t used_bytes() const noexcept { return capacity_ - free_bytes_; }
+
+    // Largest free payload. Only the highest non-empty size class is inspected.
+    std::size_t largest_free_gap() const noexcept {
+        if (fl_bitmap_ == 0) {
+            return 0;
+        }
+        const unsigned fl = static_cast<unsigned>(std::bit_width(fl_bitmap_)) - 1;
+        const unsigned sl = static_cast<unsigned>(std::bit_width(sl_bitmap_[fl])) - 1;
+        std::size_t largest = 0;
+        for (const Header* block = free_lists_[fl][sl]; block != nullptr; block = block->next_free) {
+            largest = block->size() > largest ? block->size() : largest;
+        }
+        return largest;
+    }
+
+private:
+    struct Header {
+        Header* prev_physical;
+        std::size_t size_and_flags;
+        // Valid only while the block is free; they occupy the first payload bytes.
+        Header* next_free{nullptr};
+        Header* prev_free{nullptr};
+
+        std::size_t size() const noexcept { return size_and_flags & ~kFlagMask; }
+        void set_size(std::size_t size) noexcept { size_and_flags = size | (size_and_flags & kFlagMask); }
+        bool is_free() const noexcept { return (size_and_flags & kFreeBit) != 0; }
+        bool is_prev_free() const noexcept { return (size_and_flags & kPrevFreeBit) != 0; }
+        void set_free() noexcept { size_and_flags |= kFreeBit; }
+        void set_used() noexcept { size_and_flags &= ~kFreeBit; }
+        void set_prev_free() noexcept { size_and_flags |= kPrevFreeBit; }
+        void set_prev_used() noexcept { size_and_flags &= ~kPrevFreeBit; }
+    };
+
+    static constexpr std::size_t kFreeBit = 1;
+    static constexpr std::size_t kPrevFreeBit = 2;
+    static constexpr std::size_t kFlagMask = kFreeBit | kPrevFreeBit;
+
+    static constexpr std::size_t kAlignLog2 = 4;
+    static constexpr std::size_t kAlign = std::size_t{1} << kAlignLog2;
+    static constexpr std::size_t kSlCountLog2 = 4;
+    static constexpr std::size_t kSlCount = std::size_t{1} << kSlCountLog2;
+    static constexpr std::size_t kFlShift = kSlCountLog2 + kAlignLog2;
+    static constexpr std::size_t kSmallBlock = std::size_t{1} << kFlShift;
+    static constexpr std::size_t kFlMax = 40;
+    static constexpr std::size_t kFlCount = kFlMax - kFlShift + 1;
+    static constexpr std::size_t kMaxBlockSize = std::size_t{1} << kFlMax;
+
+    // Header without the free-list links; the links live in the payload of free blocks.
+    static constexpr std::size_t kHeaderBytes = offsetof(Header, next_free);
+    static constexpr std::size_t kMinPayload = sizeof(Header) - kHeaderBytes;
+
+    static_assert(kHeaderBytes == kAlign, "Block header must keep payloads 16-byte aligned");
+    static_assert(sizeof(std::uint32_t) * 8 >= kSlCount, "Second-level bitmap is too narrow");
+    static_assert(sizeof(std::uint64_t) * 8 >= kFlCount, "First-level bitmap is too narrow");
+
+    std::size_t capacity_;
+    std::size_t buffer_alignment_;
+    std::byte* buffer_{nullptr};
+    std::size_t free_bytes_{0};
+    std::uint64_t fl_bitmap_{0};
+    std::array<std::uint32_t, kFlCount> sl_bitmap_{};
+    std::array<std::array<Header*, kSlCount>, kFlCount> free_lists_{};
+
+    static std::byte* payload_of(Header* block) noexcept {
+        return reinterpret_cast<std::byte*>(block) + kHeaderBytes;
+    }
+
+    static Header* header_of(void* payload) noexcept {
+        return reinterpret_cast<Header*>(static_cast<std::byte*>(payload) - kHeaderBytes);
+    }
+
+    static Header* next_physical(Header* block) noexcept {
+        return reinterpret_cast<Header*>(payload_of(block) + block->size());
+    }
+
+    static std::size_t align_up(std::size_t value, std::size_t alignment) noexcept {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Size class that `size` belongs to.
+    static void mapping_insert(std::size_t size, unsigned& fl, unsigned& sl) noexcept {
+        if (size < kSmallBlock) {
+            fl = 0;
+            sl = static_cast<unsigned>(size / (kSmallBlock / kSlCount));
+            return;
+        }
+        const unsigned top = static_cast<unsigned>(std::bit_width(size)) - 1;
+        sl = static_cast<unsigned>((size >> (top - kSlCountLog2)) ^ kSlCount);
+        fl = top - static_cast<unsigned>(kFlShift - 1);
+    }
+
+    // First size class whose every block is at least `size` bytes.
+    static void mapping_search(std::size_t size, unsigned& fl, unsigned& sl) noexcept {
+        if (size >= kSmallBlock) {
+            const unsigned top = static_cast<unsigned>(std::bit_width(size)) - 1;
+            size += (std::size_t{1} << (top - kSlCountLog2)) - 1;
+        }
+        mapping_insert(size, fl, sl);
+    }
+
+    Header* find_suitable(unsigned& fl, unsigned& sl) const noexcept {
+        if (fl >= kFlCount) {
+            return nullptr;
+        }
+        std::uint32_t sl_map = sl_bitmap_[fl] & (~std::uint32_t{0} << sl);
+        if (sl_map == 0) {
+            const std::uint64_t fl_map = fl + 1 >= 64 ? 0 : fl_bitmap_ & (~std::uint64_t{0} << (fl + 1));
+            if (fl_map == 0) {
+                return nullptr;
+            }
+            fl = static_cast<unsigned>(std::countr_zero(fl_map));
+            sl_map = sl_bitmap_[fl];
+        }
+        sl = static_cast<unsigned>(std::countr_zero(sl_map));
+        return free_lists_[fl][sl];
+    }
+
+    void insert_free(Header* block) noexcept {
+        unsigned fl = 0;
+        unsigned sl = 0;
+        mapping_insert(block->size(), fl, sl);
+        Header*& head = free_lists_[fl][sl];
+        block->prev_free = nullptr;
+        block->next_free = head;
+        if (head != nullptr) {
+            head->prev_free = block;
+        }
+        head = block;
+        fl_bitmap_ |= std::uint64_t{1} << fl;
+        sl_bitmap_[fl] |= std::uint32_t{1} << sl;
+        free_bytes_ += block->size();
+    }
+
+    void remove_free(Header* block) noexcept {
+        unsigned fl = 0;
+        unsigned sl = 0;
+        mapping_insert(block->size(), fl, sl);
+        if (block->prev_free != nullptr) {
+            block->prev_free->next_free = block->next_free;
+        } else {
+            free_lists_[fl][sl] = block->next_free;
+        }
+        if (block->next_free != nullptr) {
+            block->next_free->prev_free = block->prev_free;
+        }
+        if (free_lists_[fl][sl] == nullptr) {
+            sl_bitmap_[fl] &= ~(std::uint32_t{1} << sl);
+            if (sl_bitmap_[fl] == 0) {
+                fl_bitmap_ &= ~(std::uint64_t{1} << fl);
+            }
+        }
+        free_bytes_ -= block->size();
+    }
+
+    void mark_free(Header* block) noexcept {
+        block->set_free();
+        Header* next = next_physical(block);
+        next->prev_physical = block;
+        next->set_prev_free();
+    }
+
+    void mark_used(Header* block) noexcept {
+        block->set_used();
+        next_physical(block)->set_prev_used();
+    }
+
+    // Cuts `block` (not in any list) after `size` payload bytes and returns the remainder,
+    // or nullptr if the remainder would be too small to stand alone.
+    Header* split(Header* block, std::size_t size) noexcept {
+        if (block->size() < size + kHeaderBytes + kMinPayload) {
+            return nullptr;
+        }
+        auto* rest = ::new (static_cast<void*>(payload_of(block) + size))
+            Header{block, block->size() - size - kHeaderBytes};
+        block->set_size(size);
+        next_physical(rest)->prev_physical = rest;
+        return rest;
+    }
+
+    // Merges the free neighbour that follows `block` into it.
+    Header* absorb_next(Header* block) noexcept {
+        Header* next = next_physical(block);
+        remove_free(next);
+        block->set_size(block->size() + kHeaderBytes + next->size());
+        next_physical(block)->prev_physical = block;
+        return block;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const std::size_t required_alignment = alignment == 0 ? alignof(std::max_align_t) : alignment;
+        if (required_alignment > buffer_alignment_ || bytes > kMaxBlockSize / 2) {
+            throw std::bad_alloc();
+        }
+        const std::size_t size = align_up(bytes < kMinPayload ? kMinPayload : bytes, kAlign);
+
+        // Over-aligned requests reserve room for a leading free block of at least minimal size.
+        const std::size_t leading_min = kHeaderBytes + kMinPayload;
+        const std::size_t search_size = required_alignment <= kAlign ? size : size + required_alignment + leading_min;
+
+        unsigned fl = 0;
+        unsigned sl = 0;
+        mapping_search(search_size, fl, sl);
+        Header* block = find_suitable(fl, sl);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        remove_free(block);
+
+        if (required_alignment > kAlign) {
+            const auto payload = reinterpret_cast<std::uintptr_t>(payload_of(block));
+            std::uintptr_t aligned = align_up(payload, required_alignment);
+            if (aligned != payload && aligned - payload < leading_min) {
+                aligned = align_up(payload + leading_min, required_alignment);
+            }
+            const std::size_t gap = aligned - payload;
+            if (gap != 0) {
+                Header* leading = block;
+                block = ::new (static_cast<void*>(payload_of(leading) + gap - kHeaderBytes))
+                    Header{leading, leading->size() - gap};
+                leading->set_size(gap - kHeaderBytes);
+                next_physical(block)->prev_physical = block;
+                block->set_prev_free();
+                leading->set_free();
+                insert_free(leading);
+            }
+        }
+
+        if (Header* rest = split(block, size)) {
+            rest->set_used();
+            rest->set_prev_used();
+            mark_free(rest);
+            insert_free(rest);
+        }
+        mark_used(block);
+        return payload_of(block);
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t) override {
+        if (ptr == nullptr) {
+            return;
+        }
+        const auto byte_ptr = static_cast<std::byte*>(ptr);
+        if (byte_ptr < buffer_ + kHeaderBytes || byte_ptr >= buffer_ + capacity_) {
+            throw std::logic_error("Pointer does not belong to this resource");
+        }
+        Header* block = header_of(ptr);
+        if (block->is_free()) {
+            throw std::logic_error("Attempt to deallocate unmanaged block");
+        }
+
+        if (block->is_prev_free()) {
+            Header* previous = block->prev_physical;
+            remove_free(previous);
+            previous->set_size(previous->size() + kHeaderBytes + block->size());
+            next_physical(previous)->prev_physical = previous;
+            block = previous;
+        }
+        if (next_physical(block)->is_free()) {
+            absorb_next(block);
+        }
+        mark_free(block);
+        insert_free(block);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
@@ -0,0 +1,467 @@
+#pragma once
+
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Chase-Lev work-stealing deque. The owner pushes and pops at the bottom, any other thread
+// steals from the top. Slot arrays come from a memory resource that only the owner touches:
+// growth happens in push(), and retired arrays are kept until destruction because a thief
+// may still be reading them.
+template <class T>
+class ChaseLevDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "Deque elements must be trivially copyable");
+    static_assert(std::atomic<T>::is_always_lock_free, "Deque elements must be lock-free atomics");
+
+public:
+    explicit ChaseLevDeque(std::pmr::memory_resource* resource, std::size_t initial_capacity = 64)
+        : resource_(resource) {
+        std::size_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity <<= 1;
+        }
+        array_.store(make_array(capacity), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    ~ChaseLevDeque() {
+        Array* array = array_.load(std::memory_order_relaxed);
+        while (array != nullptr) {
+            Array* retired = array->retired;
+            destroy_array(array);
+            array = retired;
+        }
+    }
+
+    // Owner only. Returns false if the array had to grow and the resource is exhausted.
+    bool push(T value) {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<std::int64_t>(array->mask)) {
+            array = grow(array, top, bottom);
+            if (array == nullptr) {
+                return false;
+            }
+        }
+        array->slot(bottom).store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only. Takes the most recently pushed element.
+    bool pop(T& out) {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = array->slot(bottom).load(std::memory_order_relaxed);
+        if (top == bottom) {
+            const bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread. Takes the oldest element; fails on an empty deque or a lost race.
+    bool steal(T& out) {
+        std::int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        Array* array = array_.load(std::memory_order_acquire);
+        out = array->slot(top).load(std::memory_order_relaxed);
+        return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    std::size_t size_hint() const noexcept {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
+
+private:
+    struct Array {
+        std::size_t mask;
+        Array* retired;
+
+        std::atomic<T>* slots() noexcept { return reinterpret_cast<std::atomic<T>*>(this + 1); }
+        std::atomic<T>& slot(std::int64_t index) noexcept {
+            return slots()[static_cast<std::size_t>(index) & mask];
+        }
+    };
+
+    static_assert(alignof(Array) >= alignof(std::atomic<T>), "Slots must follow the array header");
+
+    std::pmr::memory_resource* resource_;
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    alignas(64) std::atomic<Array*> array_{nullptr};
+
+    static std::size_t array_bytes(std::size_t capacity) noexcept {
+        return sizeof(Array) + capacity * sizeof(std::atomic<T>);
+    }
+
+    Array* make_array(std::size_t capacity) {
+        auto* array = static_cast<Array*>(resource_->allocate(array_bytes(capacity), alignof(Array)));
+        array->mask = capacity - 1;
+        array->retired = nullptr;
+        std::uninitialized_default_construct_n(array->slots(), capacity);
+        return array;
+    }
+
+    void destroy_array(Array* array) noexcept {
+        resource_->deallocate(array, array_bytes(array->mask + 1), alignof(Array));
+    }
+
+    Array* grow(Array* old_array, std::int64_t top, std::int64_t bottom) {
+        Array* array = nullptr;
+        try {
+            array = make_array((old_array->mask + 1) * 2);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+        for (std::int64_t index = top; index < bottom; ++index) {
+            array->slot(index).store(old_array->slot(index).load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+        }
+        array->retired = old_array;
+        array_.store(array, std::memory_order_release);
+        return array;
+    }
+};
+
+class TaskGroup;
+
+// Thread pool where every worker owns a ChaseLevDeque backed by its own
+// CustomBlockMemoryResource. Work spawned on a worker goes to its deque; work submitted from
+// outside goes to a shared injection queue. Idle workers steal from the top of other deques
+// before parking.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(std::size_t worker_count = std::max(1u, std::thread::hardware_concurrency()),
+                              std::size_t worker_arena_bytes = 1 << 16)
+        : injection_(&job_resource_) {
+        if (worker_count == 0) {
+            throw std::invalid_argument("Worker count must be greater than zero");
+        }
+        workers_.reserve(worker_count);
+        for (std::size_t index = 0; index < worker_count; ++index) {
+            workers_.push_back(std::make_unique<Worker>(*this, index, worker_arena_bytes));
+        }
+        for (auto& worker : workers_) {
+            worker->thread = std::thread([this, raw = worker.get()] { run_worker(*raw); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool() {
+        wait_idle_noexcept();
+        {
+            std::lock_guard lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+    }
+
+    std::size_t worker_count() const noexcept { return workers_.size(); }
+
+    template <class F>
+    void submit(F&& fn) {
+        enqueue(make_job(std::forward<F>(fn), nullptr));
+    }
+
+    // Blocks until every submitted job has finished; rethrows the first escaped exception.
+    void wait_idle() {
+        wait_idle_noexcept();
+        std::exception_ptr error;
+        {
+            std::lock_guard lock(idle_mutex_);
+            error = std::exchange(first_error_, nullptr);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    friend class TaskGroup;
+
+    struct Job {
+        void (*invoke)(Job*, std::pmr::memory_resource*);
+        TaskGroup* group;
+    };
+
+    template <class F>
+    struct CallableJob : Job {
+        F fn;
+
+        template <class U>
+        explicit CallableJob(U&& callable, TaskGroup* owner)
+            : Job{&CallableJob::run, owner}, fn(std::forward<U>(callable)) {}
+
+        // Runs the callable and releases the job storage even if it throws.
+        static void run(Job* job, std::pmr::memory_resource* resource) {
+            auto* self = static_cast<CallableJob*>(job);
+            struct Release {
+                CallableJob* self;
+                std::pmr::memory_resource* resource;
+                ~Release() {
+                    std::pmr::polymorphic_allocator<CallableJob> allocator(resource);
+                    std::allocator_traits<decltype(allocator)>::destroy(allocator, self);
+                    allocator.deallocate(self, 1);
+                }
+            } release{self, resource};
+            self->fn();
+        }
+    };
+
+    struct Worker {
+        Worker(WorkStealingPool& owner, std::size_t worker_index, std::size_t arena_bytes)
+            : pool(&owner), index(worker_index), arena(arena_bytes), deque(&arena) {}
+
+        WorkStealingPool* pool;
+        std::size_t index;
+        CustomBlockMemoryResource arena;
+        ChaseLevDeque<Job*> deque;
+        std::thread thread;
+    };
+
+    static inline thread_local Worker* current_worker_ = nullptr;
+
+    std::pmr::synchronized_pool_resource job_resource_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex injection_mutex_;
+    PmrQueue<Job*> injection_;
+
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> sleepers_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stopping_{false};
+
+    std::atomic<std::size_t> outstanding_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::exception_ptr first_error_;
+
+    Worker* local_worker() const noexcept {
+        return current_worker_ != nullptr && current_worker_->pool == this ? current_worker_ : nullptr;
+    }
+
+    template <class F>
+    Job* make_job(F&& fn, TaskGroup* group) {
+        using JobType = CallableJob<std::decay_t<F>>;
+        std::pmr::polymorphic_allocator<JobType> allocator(&job_resource_);
+        JobType* job = allocator.allocate(1);
+        try {
+            std::allocator_traits<decltype(allocator)>::construct(allocator, job, std::forward<F>(fn), group);
+        } catch (...) {
+            allocator.deallocate(job, 1);
+            throw;
+        }
+        return job;
+    }
+
+    void enqueue(Job* job) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        Worker* worker = local_worker();
+        if (worker != nullptr) {
+            if (!worker->deque.push(job)) {
+                // The worker arena cannot grow the deque any further: run the job in place.
+                execute(job);
+                return;
+            }
+        } else {
+            std::lock_guard lock(injection_mutex_);
+            injection_.push(job);
+        }
+        queued_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            {
+                std::lock_guard lock(sleep_mutex_);
+            }
+            sleep_cv_.notify_one();
+        }
+    }
+
+    // Own deque first, then the injection queue, then the other workers' deques.
+    Job* find_job(Worker* self) {
+        Job* job = nullptr;
+        if (self != nullptr && self->deque.pop(job)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+        {
+            std::lock_guard lock(injection_mutex_);
+            if (!injection_.empty()) {
+                job = injection_.front();
+                injection_.pop();
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        const std::size_t start = self != nullptr ? self->index + 1 : 0;
+        for (std::size_t offset = 0; offset < workers_.size(); ++offset) {
+            Worker& victim = *workers_[(start + offset) % workers_.size()];
+            if (&victim != self && victim.deque.steal(job)) {
+                queued_.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void execute(Job* job);
+
+    void run_worker(Worker& self) {
+        current_worker_ = &self;
+        while (true) {
+            if (Job* job = find_job(&self)) {
+                execute(job);
+                continue;
+            }
+            if (queued_.load(std::memory_order_seq_cst) > 0) {
+                // A job is in flight between a push and its counter update; retry shortly.
+                std::this_thread::yield();
+                continue;
+            }
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            {
+                std::unique_lock lock(sleep_mutex_);
+                sleep_cv_.wait(lock, [this] {
+                    return stopping_ || queued_.load(std::memory_order_seq_cst) > 0;
+                });
+            }
+            sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+            std::lock_guard lock(sleep_mutex_);
+            if (stopping_ && queued_.load(std::memory_order_seq_cst) == 0) {
+                break;
+            }
+        }
+        current_worker_ = nullptr;
+    }
+
+    void record_error(std::exception_ptr error) {
+        std::lock_guard lock(idle_mutex_);
+        if (!first_error_) {
+            first_error_ = std::move(error);
+        }
+    }
+
+    void finish_job() {
+        if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard lock(idle_mutex_);
+            idle_cv_.notify_all();
+        }
+    }
+
+    void wait_idle_noexcept() {
+        std::unique_lock lock(idle_mutex_);
+        idle_cv_.wait(lock, [this] { return outstanding_.load(std::memory_order_acquire) == 0; });
+    }
+};
+
+// Fork-join scope over a WorkStealingPool. wait() executes pending jobs on the calling thread
+// instead of blocking, so recursive groups never starve the pool.
+class TaskGroup {
+public:
+    explicit TaskGroup(WorkStealingPool& pool) : pool_(&pool) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        help_until_done();
+    }
+
+    template <class F>
+    void run(F&& fn) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_->enqueue(pool_->make_job(std::forward<F>(fn), this));
+    }
+
+    // Returns once every job spawned through run() has finished; rethrows the first exception.
+    void wait() {
+        help_until_done();
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    friend class WorkStealingPool;
+
+    WorkStealingPool* pool_;
+    std::atomic<std::size_t> pending_{0};
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    void help_until_done() {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            if (WorkStealingPool::Job* job = pool_->find_job(pool_->local_worker())) {
+                pool_->execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void record_error(std::exception_ptr error) {
+        std::lock_guard lock(error_mutex_);
+        if (!error_) {
+            error_ = std::move(error);
+        }
+    }
+};
+
+inline void WorkStealingPool::execute(Job* job) {
+    TaskGroup* group = job->group;
+    try {
+        job->invoke(job, &job_resource_);
+    } catch (...) {
+        if (group != nullptr) {
+            group->record_error(std::current_exception());
+        } else {
+            record_error(std::current_exception());
+        }
+    }
+    if (group != nullptr) {
+        group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    finish_job();
+}
@@ -5,7 +5,19 @@
 #include <memory_resource>
 #include <string_view>
 
+// Allocator-aware, so a queue constructs the title inside its own memory resource.
 struct Task {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    Task(std::string_view task_title, int task_priority, double task_weight, const allocator_type& alloc = {})
+        : title(task_title, alloc), priority(task_priority), weight(task_weight) {}
+
+    Task(const Task& other, const allocator_type& alloc)
+        : title(other.title, alloc), priority(other.priority), weight(other.weight) {}
+
+    Task(Task&& other, const allocator_type& alloc)
+        : title(std::move(other.title), alloc), priority(other.priority), weight(other.weight) {}
+
     std::pmr::string title;
     int priority;
     double weight;
@@ -28,12 +40,11 @@ void demonstrate_int_queue(CustomBlockMemoryResource& resource) {
 }
 
 void demonstrate_task_queue(CustomBlockMemoryResource& resource) {
-    std::pmr::polymorphic_allocator<char> string_allocator(&resource);
     PmrQueue<Task> queue(&resource);
 
-    queue.emplace(Task{std::pmr::string("Alpha", string_allocator), 1, 3.5});
-    queue.emplace(Task{std::pmr::string("Beta", string_allocator), 2, 1.2});
-    queue.emplace(Task{std::pmr::string("Gamma", string_allocator), 3, 4.8});
+    queue.emplace("Alpha", 1, 3.5);
+    queue.emplace("Beta", 2, 1.2);
+    queue.emplace("Gamma", 3, 4.8);
 
     std::cout << "\nTask queue contents:\n";
     for (const Task& task : queue) {
@@ -1,11 +1,47 @@
+#include "allocation_trace.hpp"
+#include "async_pmr_queue.hpp"
+#include "batch_exchange_queue.hpp"
+#include "blocking_pmr_queue.hpp"
+#include "buddy_memory_resource.hpp"
+#include "compact_pmr_queue.hpp"
+#include "durable_pmr_queue.hpp"
+#include "inline_pmr_queue.hpp"
+#include "intrusive_queue.hpp"
 #include "memory_resource.hpp"
+#include "node_reclaimer.hpp"
+#include "notifying_pmr_queue.hpp"
 #include "pmr_queue.hpp"
+#include "queue_serializer.hpp"
+#include "queue_snapshot.hpp"
+#include "queue_telemetry.hpp"
+#include "shared_memory_queue.hpp"
+#include "shared_memory_resource.hpp"
+#include "spilling_pmr_queue.hpp"
+#include "static_block_memory_resource.hpp"
+#include "tenant_memory_resource.hpp"
+#include "tlsf_memory_resource.hpp"
+#include "work_stealing_pool.hpp"
 
 #include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <memory_resource>
+#include <random>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 // Проверяет стандартный FIFO-порядок очереди.
@@ -136,3 +172,1647 @@ TEST(FixedMemoryResourceTest, ThrowsOnOverflow) {
     alloc.deallocate(a, 16);
     alloc.deallocate(b, 16);
 }
+
+// Проверяет, что splice переносит все узлы другой очереди в конец без копирования.
+TEST(PmrQueueTest, SpliceAppendsOtherQueue) {
+    CustomBlockMemoryResource resource(512);
+    PmrQueue<int> first(&resource);
+    PmrQueue<int> second(&resource);
+    first.push(1);
+    second.push(2);
+    second.push(3);
+
+    const int* moved = &second.front();
+    first.splice(second);
+
+    EXPECT_TRUE(second.empty());
+    std::vector<int> collected(first.begin(), first.end());
+    EXPECT_EQ(collected, (std::vector<int>{1, 2, 3}));
+    first.pop();
+    EXPECT_EQ(&first.front(), moved);
+}
+
+struct PooledMessage {
+    int id;
+    IntrusiveQueueHook<PooledMessage> queue_hook;
+};
+
+// Проверяет FIFO-порядок интрузивной очереди и отсутствие перемещения элементов.
+TEST(IntrusiveQueueTest, PreservesFifoOrderWithoutCopies) {
+    PooledMessage a{1, {}};
+    PooledMessage b{2, {}};
+    PooledMessage c{3, {}};
+    IntrusiveQueue<PooledMessage> queue;
+
+    queue.push(a);
+    queue.push(b);
+    queue.push(c);
+    EXPECT_EQ(queue.size(), 3u);
+
+    EXPECT_EQ(&queue.front(), &a);
+    queue.pop();
+    EXPECT_EQ(&queue.front(), &b);
+    queue.pop();
+    EXPECT_EQ(&queue.front(), &c);
+    queue.pop();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_THROW(queue.pop(), std::out_of_range);
+}
+
+// Проверяет итерацию и splice для интрузивной очереди.
+TEST(IntrusiveQueueTest, IteratesAndSplices) {
+    PooledMessage messages[4]{{0, {}}, {1, {}}, {2, {}}, {3, {}}};
+    IntrusiveQueue<PooledMessage> first;
+    IntrusiveQueue<PooledMessage> second;
+    first.push(messages[0]);
+    first.push(messages[1]);
+    second.push(messages[2]);
+    second.push(messages[3]);
+
+    first.splice(second);
+    EXPECT_TRUE(second.empty());
+    EXPECT_EQ(first.size(), 4u);
+
+    std::vector<int> ids;
+    for (const PooledMessage& message : first) {
+        ids.push_back(message.id);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{0, 1, 2, 3}));
+}
+
+// Проверяет, что короткая очередь не обращается к ресурсу, пока помещается во встроенный буфер.
+TEST(InlinePmrQueueTest, StaysInlineForShortQueues) {
+    CustomBlockMemoryResource resource(16);
+    InlinePmrQueue<int, 4> queue(&resource);
+    for (int value = 0; value < 4; ++value) {
+        queue.push(value);
+    }
+    EXPECT_EQ(queue.size(), 4u);
+    EXPECT_EQ(queue.spilled_size(), 0u);
+
+    // Весь буфер ресурса по-прежнему свободен.
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+    std::byte* whole = alloc.allocate(16);
+    alloc.deallocate(whole, 16);
+}
+
+// Проверяет FIFO-порядок и итерацию через границу встроенного буфера и ресурса.
+TEST(InlinePmrQueueTest, PreservesOrderAcrossSpillBoundary) {
+    CustomBlockMemoryResource resource(1024);
+    InlinePmrQueue<int, 2> queue(&resource);
+    for (int value = 1; value <= 5; ++value) {
+        queue.push(value);
+    }
+    EXPECT_EQ(queue.spilled_size(), 3u);
+
+    std::vector<int> collected(queue.begin(), queue.end());
+    EXPECT_EQ(collected, (std::vector<int>{1, 2, 3, 4, 5}));
+
+    queue.pop();
+    queue.push(6);  // пока есть вытесненные элементы, новые идут в конец ресурса
+    std::vector<int> drained;
+    while (!queue.empty()) {
+        drained.push_back(queue.front());
+        queue.pop();
+    }
+    EXPECT_EQ(drained, (std::vector<int>{2, 3, 4, 5, 6}));
+    EXPECT_THROW(queue.pop(), std::out_of_range);
+}
+
+// Проверяет работу очереди поверх ресурса со встроенным буфером на стеке.
+TEST(StaticBlockMemoryResourceTest, BacksQueueWithoutHeap) {
+    StaticBlockMemoryResource<512> resource;
+    PmrQueue<int> queue(&resource);
+    for (int value = 0; value < 8; ++value) {
+        queue.push(value);
+    }
+    EXPECT_EQ(resource.block_count(), 8u);
+
+    std::vector<int> collected(queue.begin(), queue.end());
+    EXPECT_EQ(collected, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+    while (!queue.empty()) {
+        queue.pop();
+    }
+    EXPECT_EQ(resource.block_count(), 0u);
+}
+
+// Проверяет переиспользование дыр и выравнивание во встроенном буфере.
+TEST(StaticBlockMemoryResourceTest, ReusesHolesAndRespectsAlignment) {
+    StaticBlockMemoryResource<256, 64> resource;
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+
+    std::byte* first = alloc.allocate(16);
+    std::byte* second = alloc.allocate(16);
+    alloc.deallocate(first, 16);
+    std::byte* reused = alloc.allocate(8);
+    EXPECT_EQ(reused, first);
+
+    void* aligned = resource.allocate(32, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0u);
+    EXPECT_THROW(static_cast<void>(resource.allocate(8, 128)), std::bad_alloc);
+
+    resource.deallocate(aligned, 32, 64);
+    alloc.deallocate(second, 16);
+    alloc.deallocate(reused, 8);
+}
+
+// Проверяет, что заполнение таблицы блоков приводит к bad_alloc.
+TEST(StaticBlockMemoryResourceTest, ThrowsWhenBlockTableIsFull) {
+    StaticBlockMemoryResource<64, 16, 2> resource;
+    void* a = resource.allocate(1, 1);
+    void* b = resource.allocate(1, 1);
+    EXPECT_THROW(static_cast<void>(resource.allocate(1, 1)), std::bad_alloc);
+    resource.deallocate(a, 1, 1);
+    resource.deallocate(b, 1, 1);
+}
+
+// Проверяет, что best-fit выбирает наименьшую подходящую дыру, а worst-fit — наибольшую.
+TEST(PlacementPolicyTest, BestAndWorstFitChooseGapsBySize) {
+    auto carve_holes = [](std::pmr::memory_resource& resource, std::vector<std::byte*>& live) {
+        // Раскладка: [64 занято][32 свободно][16 занято][16 свободно][16 занято][хвост свободен]
+        std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+        std::byte* a = alloc.allocate(64);
+        std::byte* hole_big = alloc.allocate(32);
+        std::byte* b = alloc.allocate(16);
+        std::byte* hole_small = alloc.allocate(16);
+        std::byte* c = alloc.allocate(16);
+        alloc.deallocate(hole_big, 32);
+        alloc.deallocate(hole_small, 16);
+        live = {a, b, c};
+        return std::pair{hole_big, hole_small};
+    };
+
+    BestFitBlockMemoryResource best(512, 16);
+    std::vector<std::byte*> best_live;
+    const auto [best_big, best_small] = carve_holes(best, best_live);
+    EXPECT_EQ(best.allocate(16, 16), best_small);
+
+    WorstFitBlockMemoryResource worst(512, 16);
+    std::vector<std::byte*> worst_live;
+    const auto [worst_big, worst_small] = carve_holes(worst, worst_live);
+    void* tail = worst.allocate(16, 16);
+    EXPECT_NE(tail, worst_big);
+    EXPECT_NE(tail, worst_small);
+    EXPECT_EQ(worst.largest_free_gap(), 512u - 160u);
+}
+
+// Проверяет, что next-fit продолжает поиск после последнего выделения и переходит в начало.
+TEST(PlacementPolicyTest, NextFitResumesAfterLastAllocation) {
+    NextFitBlockMemoryResource resource(64, 16);
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+
+    std::byte* first = alloc.allocate(16);
+    std::byte* second = alloc.allocate(16);
+    alloc.deallocate(first, 16);
+    std::byte* third = alloc.allocate(16);
+    EXPECT_EQ(third, second + 16);  // first-fit занял бы освободившийся первый блок
+
+    std::byte* fourth = alloc.allocate(16);
+    std::byte* wrapped = alloc.allocate(16);
+    EXPECT_EQ(wrapped, first);
+    EXPECT_EQ(resource.used_bytes(), 64u);
+
+    for (std::byte* p : {second, third, fourth, wrapped}) {
+        alloc.deallocate(p, 16);
+    }
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет неблокирующие операции на границах ёмкости.
+TEST(BlockingPmrQueueTest, TryOperationsRespectCapacity) {
+    CustomBlockMemoryResource resource(1024);
+    BlockingPmrQueue<int> queue(2, &resource);
+    int value = 0;
+
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_FALSE(queue.push_for(3, std::chrono::milliseconds(5)));
+
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(queue.pop_for(value, std::chrono::milliseconds(5)));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.pop_for(value, std::chrono::milliseconds(5)));
+}
+
+// Проверяет передачу данных между потоками с блокировкой по заполнению.
+TEST(BlockingPmrQueueTest, TransfersBetweenThreadsInOrder) {
+    CustomBlockMemoryResource resource(4096);
+    BlockingPmrQueue<int> queue(4, &resource);
+    constexpr int kCount = 2000;
+
+    std::thread producer([&queue] {
+        std::vector<int> values(kCount / 2);
+        for (int value = 0; value < kCount / 2; ++value) {
+            queue.push(value);
+        }
+        for (int i = 0; i < kCount / 2; ++i) {
+            values[i] = kCount / 2 + i;
+        }
+        queue.push_bulk(values.begin(), values.end());
+        queue.close();
+    });
+
+    std::vector<int> received;
+    int value = 0;
+    while (queue.pop(value)) {
+        received.push_back(value);
+    }
+    producer.join();
+
+    ASSERT_EQ(received.size(), static_cast<std::size_t>(kCount));
+    for (int i = 0; i < kCount; ++i) {
+        EXPECT_EQ(received[i], i);
+    }
+}
+
+// Проверяет, что close будит заблокированного потребителя и запрещает новые push.
+TEST(BlockingPmrQueueTest, CloseReleasesWaiters) {
+    CustomBlockMemoryResource resource(512);
+    BlockingPmrQueue<int> queue(1, &resource);
+
+    bool popped = true;
+    std::thread consumer([&] {
+        int value = 0;
+        popped = queue.pop(value);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.close();
+    consumer.join();
+
+    EXPECT_FALSE(popped);
+    EXPECT_FALSE(queue.push(1));
+    EXPECT_TRUE(queue.closed());
+}
+
+namespace {
+
+PmrTask collect_values(std::allocator_arg_t, std::pmr::memory_resource*, AsyncPmrQueue<int>& queue, int count,
+                       std::vector<int>& out) {
+    for (int i = 0; i < count; ++i) {
+        out.push_back(co_await queue.pop());
+    }
+}
+
+PmrTask collect_into(std::allocator_arg_t, CustomBlockMemoryResource*, AsyncPmrQueue<int>& queue, std::vector<int>& out) {
+    out.push_back(co_await queue.pop());
+}
+
+struct Collector {
+    std::vector<int> values;
+
+    PmrTask collect(std::allocator_arg_t, CustomBlockMemoryResource*, AsyncPmrQueue<int>& queue) {
+        values.push_back(co_await queue.pop());
+    }
+};
+
+}  // namespace
+
+// Проверяет, что корутина приостанавливается на пустой очереди и возобновляется через исполнитель.
+TEST(AsyncPmrQueueTest, ResumesConsumerThroughExecutor) {
+    CustomBlockMemoryResource resource(4096);
+    ManualExecutor executor(&resource);
+    AsyncPmrQueue<int> queue(executor, &resource);
+    std::vector<int> received;
+
+    queue.push(1);
+    collect_values(std::allocator_arg, &resource, queue, 3, received);
+    EXPECT_EQ(received, (std::vector<int>{1}));
+    EXPECT_EQ(queue.waiting_consumers(), 1u);
+
+    queue.push(2);
+    EXPECT_EQ(received.size(), 1u);  // возобновление только через исполнитель
+    EXPECT_EQ(executor.run_pending(), 1u);
+    EXPECT_EQ(received, (std::vector<int>{1, 2}));
+
+    queue.push(3);
+    executor.run_pending();
+    EXPECT_EQ(received, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(queue.waiting_consumers(), 0u);
+}
+
+// Проверяет, что кадры свободной функции и метода берутся из ресурса, переданного указателем на наследника
+TEST(AsyncPmrQueueTest, AllocatesFramesFromDerivedResourcePointer) {
+    CustomBlockMemoryResource frames(4096);
+    InlineExecutor executor;
+    AsyncPmrQueue<int> queue(executor);
+    std::vector<int> received;
+    Collector collector;
+
+    collect_into(std::allocator_arg, &frames, queue, received);
+    const std::size_t one_frame = frames.used_bytes();
+    EXPECT_GT(one_frame, 0u);
+    collector.collect(std::allocator_arg, &frames, queue);
+    EXPECT_GT(frames.used_bytes(), one_frame);
+
+    queue.push(1);
+    queue.push(2);
+    EXPECT_EQ(received, (std::vector<int>{1}));
+    EXPECT_EQ(collector.values, (std::vector<int>{2}));
+    EXPECT_EQ(frames.used_bytes(), 0u);
+}
+
+// Проверяет, что кадр корутины размещается в переданном ресурсе и освобождается по завершении.
+TEST(AsyncPmrQueueTest, AllocatesCoroutineFramesFromResource) {
+    CustomBlockMemoryResource resource(8192);
+    InlineExecutor executor;
+    AsyncPmrQueue<int> queue(executor, &resource);
+    std::vector<int> first;
+    std::vector<int> second;
+
+    collect_values(std::allocator_arg, &resource, queue, 2, first);
+    collect_values(std::allocator_arg, &resource, queue, 1, second);
+    EXPECT_EQ(resource.block_count(), 2u);  // два кадра, узлы очереди не нужны
+
+    queue.push(10);
+    queue.push(20);
+    queue.push(30);
+    EXPECT_EQ(first, (std::vector<int>{10, 30}));
+    EXPECT_EQ(second, (std::vector<int>{20}));
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет LIFO-порядок владельца и FIFO-порядок кражи в деке Chase-Lev, включая рост массива.
+TEST(ChaseLevDequeTest, OwnerPopsNewestAndThiefStealsOldest) {
+    CustomBlockMemoryResource resource(4096);
+    ChaseLevDeque<int> deque(&resource, 2);
+    for (int value = 0; value < 10; ++value) {
+        ASSERT_TRUE(deque.push(value));
+    }
+
+    int value = -1;
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 9);
+    EXPECT_EQ(deque.size_hint(), 8u);
+}
+
+// Проверяет, что каждая задача выполняется ровно один раз при параллельных кражах.
+TEST(WorkStealingPoolTest, RunsEverySubmittedJobOnce) {
+    WorkStealingPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+
+    for (std::size_t index = 0; index < hits.size(); ++index) {
+        pool.submit([&hits, index] { hits[index].fetch_add(1, std::memory_order_relaxed); });
+    }
+    pool.wait_idle();
+
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+namespace {
+
+long parallel_fib(WorkStealingPool& pool, int n) {
+    if (n < 12) {
+        return n < 2 ? n : parallel_fib(pool, n - 1) + parallel_fib(pool, n - 2);
+    }
+    long left = 0;
+    TaskGroup group(pool);
+    group.run([&pool, &left, n] { left = parallel_fib(pool, n - 1); });
+    const long right = parallel_fib(pool, n - 2);
+    group.wait();
+    return left + right;
+}
+
+}  // namespace
+
+// Проверяет рекурсивный fork-join без взаимоблокировок и проброс исключений из группы.
+TEST(WorkStealingPoolTest, SupportsForkJoinAndPropagatesErrors) {
+    WorkStealingPool pool(3);
+    EXPECT_EQ(parallel_fib(pool, 22), 17711);
+
+    TaskGroup group(pool);
+    group.run([] { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(group.wait(), std::runtime_error);
+}
+
+// Проверяет, что кэш узлов переиспользует освобождённые узлы без обращения к ресурсу.
+TEST(PmrQueueTest, NodeCacheRecyclesPoppedNodes) {
+    CustomBlockMemoryResource resource(1024);
+    PmrQueue<int> queue(&resource);
+    queue.set_node_cache_limit(2);
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    const std::size_t blocks_in_use = resource.block_count();
+    queue.pop();
+    queue.pop();
+    queue.pop();
+    EXPECT_EQ(queue.cached_nodes(), 2u);  // третий узел возвращён ресурсу
+    EXPECT_EQ(resource.block_count(), blocks_in_use - 1);
+
+    for (int cycle = 0; cycle < 10; ++cycle) {
+        queue.push(cycle);
+        queue.pop();
+    }
+    EXPECT_EQ(resource.block_count(), 2u);
+    const PmrQueueCacheStats stats = queue.node_cache_stats();
+    EXPECT_EQ(stats.hits, 10u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_NEAR(stats.hit_rate(), 10.0 / 13.0, 1e-9);
+
+    queue.shrink();
+    EXPECT_EQ(queue.cached_nodes(), 0u);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет, что pmr-строки внутри очереди размещаются в ресурсе очереди, а не в куче по умолчанию.
+TEST(PmrQueueTest, PropagatesAllocatorToElements) {
+    CustomBlockMemoryResource resource(4096);
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        PmrQueue<std::pmr::string> queue(&resource);
+        queue.emplace("a string that is far too long for the small string buffer");
+        queue.push(std::pmr::string("another string that certainly needs a heap buffer", &resource));
+
+        EXPECT_EQ(queue.front().get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.block_count(), 4u);  // два узла и два буфера строк
+        queue.pop();
+        EXPECT_EQ(queue.front(), "another string that certainly needs a heap buffer");
+    }
+    std::pmr::set_default_resource(previous);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет, что allocator-aware структура получает ресурс очереди во всех режимах хранения.
+TEST(PmrQueueTest, PropagatesAllocatorToAllocatorAwareRecords) {
+    struct Record {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        Record(std::string_view record_name, int record_count, const allocator_type& alloc = {})
+            : name(record_name, alloc), count(record_count) {}
+        Record(Record&& other, const allocator_type& alloc)
+            : name(std::move(other.name), alloc), count(other.count) {}
+
+        std::pmr::string name;
+        int count;
+    };
+
+    CustomBlockMemoryResource resource(4096);
+    PmrQueue<Record> queue(&resource);
+    InlinePmrQueue<Record, 1> inline_queue(&resource);
+
+    queue.emplace("Alpha record with a long enough name", 1);
+    inline_queue.emplace("Beta record with a long enough name", 2);
+    inline_queue.emplace(Record("Gamma record with a long enough name", 3));
+
+    EXPECT_EQ(queue.front().name.get_allocator().resource(), &resource);
+    for (const Record& record : inline_queue) {
+        EXPECT_EQ(record.name.get_allocator().resource(), &resource);
+    }
+}
+
+// Проверяет, что reserve выделяет узлы одним вызовом и последующие push не обращаются к ресурсу.
+TEST(PmrQueueTest, ReserveServesBurstWithoutResourceCalls) {
+    CustomBlockMemoryResource resource(4096);
+    PmrQueue<int> queue(&resource);
+    queue.push(0);
+
+    queue.reserve(16);
+    EXPECT_EQ(queue.capacity(), 16u);
+    EXPECT_EQ(resource.block_count(), 2u);  // один узел и один слэб
+
+    const std::size_t used_before_burst = resource.used_bytes();
+    for (int value = 1; value < 16; ++value) {
+        queue.push(value);
+    }
+    EXPECT_EQ(queue.size(), 16u);
+    EXPECT_EQ(resource.used_bytes(), used_before_burst);
+    EXPECT_EQ(queue.node_cache_stats().reserve_hits, 15u);
+    EXPECT_EQ(queue.node_cache_stats().hits, 0u);
+
+    std::vector<int> collected(queue.begin(), queue.end());
+    EXPECT_EQ(collected.front(), 0);
+    EXPECT_EQ(collected.back(), 15);
+}
+
+// Проверяет, что shrink_to_fit освобождает слэб только после возврата всех его узлов.
+TEST(PmrQueueTest, ShrinkToFitReleasesIdleSlabs) {
+    CustomBlockMemoryResource resource(4096);
+    PmrQueue<int> queue(&resource);
+    queue.reserve(8);
+    queue.push(1);
+    queue.push(2);
+
+    queue.shrink_to_fit();
+    EXPECT_EQ(queue.capacity(), 8u);  // слэб занят, освобождать нельзя
+
+    queue.pop();
+    queue.pop();
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(queue.capacity(), 8u);
+    queue.shrink_to_fit();
+    EXPECT_EQ(queue.capacity(), 0u);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет, что splice из очереди со слэбами переносит элементы, а не чужие узлы.
+TEST(PmrQueueTest, SpliceFromReservedQueueMovesElements) {
+    CustomBlockMemoryResource resource(4096);
+    PmrQueue<int> target(&resource);
+    {
+        PmrQueue<int> source(&resource);
+        source.reserve(4);
+        source.push(7);
+        source.push(8);
+        target.splice(source);
+        EXPECT_TRUE(source.empty());
+    }
+    std::vector<int> collected(target.begin(), target.end());
+    EXPECT_EQ(collected, (std::vector<int>{7, 8}));
+    target.pop();
+    target.pop();
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет, что жёсткая квота ограничивает только своего арендатора, не затрагивая остальных.
+TEST(TenantMemoryResourceTest, HardQuotaIsolatesRunawayTenant) {
+    CustomBlockMemoryResource shared(4096);
+    TenantMemoryResource runaway(&shared, 256);
+    TenantMemoryResource quiet(&shared, 1024);
+    PmrQueue<std::uint64_t> runaway_queue(&runaway);
+    PmrQueue<std::uint64_t> quiet_queue(&quiet);
+
+    EXPECT_THROW(
+        {
+            for (std::uint64_t value = 0; value < 1000; ++value) {
+                runaway_queue.push(value);
+            }
+        },
+        std::bad_alloc);
+    EXPECT_LE(runaway.usage().bytes_in_use, runaway.hard_quota());
+    EXPECT_EQ(runaway.usage().rejected, 1u);
+
+    quiet_queue.push(42);
+    EXPECT_EQ(quiet_queue.front(), 42u);
+    EXPECT_EQ(shared.used_bytes(), runaway.usage().bytes_in_use + quiet.usage().bytes_in_use);
+}
+
+// Проверяет учёт мягкого порога и счётчиков арендатора.
+TEST(TenantMemoryResourceTest, TracksSoftLimitAndCounters) {
+    CustomBlockMemoryResource shared(1024);
+    TenantMemoryResource tenant(&shared, 128, 64);
+    std::pmr::polymorphic_allocator<std::byte> alloc(&tenant);
+
+    std::byte* first = alloc.allocate(48);
+    EXPECT_FALSE(tenant.over_soft_limit());
+    std::byte* second = alloc.allocate(48);
+    EXPECT_TRUE(tenant.over_soft_limit());
+    EXPECT_EQ(tenant.usage().soft_limit_crossings, 1u);
+    EXPECT_EQ(tenant.remaining(), 32u);
+
+    alloc.deallocate(second, 48);
+    alloc.deallocate(first, 48);
+    EXPECT_FALSE(tenant.over_soft_limit());
+    EXPECT_EQ(tenant.usage().peak_bytes, 96u);
+    EXPECT_EQ(tenant.usage().allocations, 2u);
+    EXPECT_EQ(tenant.usage().deallocations, 2u);
+    EXPECT_THROW(TenantMemoryResource(&shared, 16, 32), std::invalid_argument);
+}
+
+// Проверяет переходы уровней давления по занятым байтам и вызов обработчика.
+TEST(FixedMemoryResourceTest, ReportsUsedBytesWatermarks) {
+    CustomBlockMemoryResource resource(256, 16);
+    std::vector<std::pair<MemoryPressure, MemoryPressure>> transitions;
+    resource.set_watermarks(MemoryWatermarks{64, 128, 192});
+    resource.set_pressure_callback([&transitions](MemoryPressure previous, MemoryPressure current) {
+        transitions.emplace_back(previous, current);
+    });
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+
+    std::byte* a = alloc.allocate(64);
+    EXPECT_EQ(resource.pressure(), MemoryPressure::low);
+    std::byte* b = alloc.allocate(128);
+    EXPECT_EQ(resource.pressure(), MemoryPressure::critical);
+    alloc.deallocate(b, 128);
+    EXPECT_EQ(resource.pressure(), MemoryPressure::low);
+    alloc.deallocate(a, 64);
+    EXPECT_EQ(resource.pressure(), MemoryPressure::normal);
+
+    const std::vector<std::pair<MemoryPressure, MemoryPressure>> expected{
+        {MemoryPressure::normal, MemoryPressure::low},
+        {MemoryPressure::low, MemoryPressure::critical},
+        {MemoryPressure::critical, MemoryPressure::low},
+        {MemoryPressure::low, MemoryPressure::normal},
+    };
+    EXPECT_EQ(transitions, expected);
+    EXPECT_THROW(resource.set_watermarks(MemoryWatermarks{128, 64, 0}), std::invalid_argument);
+}
+
+// Проверяет уровень давления по наибольшему свободному промежутку при фрагментации.
+TEST(FixedMemoryResourceTest, ReportsFragmentationWatermark) {
+    CustomBlockMemoryResource resource(128, 16);
+    MemoryWatermarks watermarks;
+    watermarks.gap_high = 32;
+    watermarks.gap_check_interval = 1;
+    resource.set_watermarks(watermarks);
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+
+    std::vector<std::byte*> blocks;
+    for (int i = 0; i < 8; ++i) {
+        blocks.push_back(alloc.allocate(16));
+    }
+    for (int i = 0; i < 8; i += 2) {
+        alloc.deallocate(blocks[i], 16);
+    }
+    // Свободна половина буфера, но только кусками по 16 байт.
+    EXPECT_EQ(resource.used_bytes(), 64u);
+    EXPECT_EQ(resource.pressure(), MemoryPressure::high);
+
+    for (int i = 1; i < 8; i += 2) {
+        alloc.deallocate(blocks[i], 16);
+    }
+    EXPECT_EQ(resource.pressure(), MemoryPressure::normal);
+}
+
+// Проверяет разбиение блоков и слияние «приятелей» обратно в целый буфер.
+TEST(BuddyMemoryResourceTest, SplitsAndCoalescesBuddies) {
+    BuddyMemoryResource resource(1024, 32);
+    std::pmr::polymorphic_allocator<std::byte> alloc(&resource);
+
+    std::byte* a = alloc.allocate(32);
+    std::byte* b = alloc.allocate(32);
+    std::byte* c = alloc.allocate(100);  // округляется до 128
+    EXPECT_EQ(b, a + 32);
+    EXPECT_EQ((c - a) % 128, 0);
+    EXPECT_EQ(resource.used_bytes(), 192u);
+    EXPECT_EQ(resource.requested_bytes(), 164u);
+    EXPECT_EQ(resource.largest_free_gap(), 512u);
+
+    alloc.deallocate(a, 32);
+    alloc.deallocate(c, 100);
+    alloc.deallocate(b, 32);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+    EXPECT_EQ(resource.largest_free_gap(), 1024u);
+
+    std::byte* whole = alloc.allocate(1024);
+    EXPECT_EQ(whole, a);
+    EXPECT_THROW(static_cast<void>(alloc.allocate(1)), std::bad_alloc);
+    alloc.deallocate(whole, 1024);
+}
+
+// Проверяет работу очереди поверх buddy-ресурса и обнаружение повторного освобождения.
+TEST(BuddyMemoryResourceTest, BacksQueueAndRejectsDoubleFree) {
+    BuddyMemoryResource resource(4096, 32);
+    PmrQueue<int> queue(&resource);
+    for (int value = 0; value < 50; ++value) {
+        queue.push(value);
+    }
+    std::vector<int> collected(queue.begin(), queue.end());
+    EXPECT_EQ(collected.size(), 50u);
+    EXPECT_EQ(collected.back(), 49);
+    while (!queue.empty()) {
+        queue.pop();
+    }
+    EXPECT_EQ(resource.used_bytes(), 0u);
+
+    void* p = resource.allocate(64, 16);
+    resource.deallocate(p, 64, 16);
+    EXPECT_THROW(resource.deallocate(p, 64, 16), std::logic_error);
+    EXPECT_THROW(BuddyMemoryResource(1000), std::invalid_argument);
+}
+
+// Проверяет разбиение свободного блока и немедленное слияние соседей при освобождении.
+TEST(TlsfMemoryResourceTest, SplitsAndCoalescesNeighbours) {
+    TlsfMemoryResource resource(4096);
+    const std::size_t full_gap = resource.largest_free_gap();
+    const std::size_t overhead = resource.used_bytes();
+    EXPECT_EQ(resource.capacity() - overhead, full_gap);
+
+    void* a = resource.allocate(100);
+    void* b = resource.allocate(40);
+    void* c = resource.allocate(200);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a) % alignof(std::max_align_t), 0u);
+    EXPECT_LT(static_cast<std::byte*>(a), static_cast<std::byte*>(b));
+    EXPECT_LT(static_cast<std::byte*>(b), static_cast<std::byte*>(c));
+    EXPECT_LT(resource.largest_free_gap(), full_gap - 340);
+
+    resource.deallocate(a, 100);
+    resource.deallocate(c, 200);
+    resource.deallocate(b, 40);
+    EXPECT_EQ(resource.used_bytes(), overhead);
+    EXPECT_EQ(resource.largest_free_gap(), full_gap);
+
+    void* whole = resource.allocate(full_gap - 128);
+    EXPECT_EQ(whole, a);
+    EXPECT_THROW(static_cast<void>(resource.allocate(full_gap)), std::bad_alloc);
+    resource.deallocate(whole, full_gap - 128);
+}
+
+// Проверяет выравнивание, случайную нагрузку с очередью и обнаружение ошибочного освобождения.
+TEST(TlsfMemoryResourceTest, AlignsRandomWorkloadAndRejectsBadFree) {
+    TlsfMemoryResource resource(1 << 16, 256);
+    const std::size_t full_gap = resource.largest_free_gap();
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<std::size_t> size_dist(1, 600);
+    std::vector<std::pair<void*, std::size_t>> live;
+    for (int step = 0; step < 2000; ++step) {
+        if (live.size() > 40 || (!live.empty() && step % 3 == 0)) {
+            const std::size_t victim = rng() % live.size();
+            resource.deallocate(live[victim].first, live[victim].second);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+        const std::size_t alignment = step % 7 == 0 ? 256 : 16;
+        const std::size_t size = size_dist(rng);
+        void* p = resource.allocate(size, alignment);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignment, 0u);
+        live.emplace_back(p, size);
+    }
+    {
+        PmrQueue<int> queue(&resource);
+        for (int value = 0; value < 100; ++value) {
+            queue.push(value);
+        }
+        EXPECT_EQ(queue.front(), 0);
+    }
+    for (const auto& [ptr, size] : live) {
+        resource.deallocate(ptr, size);
+    }
+    EXPECT_EQ(resource.largest_free_gap(), full_gap);
+
+    void* p = resource.allocate(64);
+    resource.deallocate(p, 64);
+    EXPECT_THROW(resource.deallocate(p, 64), std::logic_error);
+    int outside = 0;
+    EXPECT_THROW(resource.deallocate(&outside, sizeof(outside)), std::logic_error);
+    EXPECT_THROW(TlsfMemoryResource(16), std::invalid_argument);
+    EXPECT_THROW(TlsfMemoryResource((std::size_t{1} << 40) + 64), std::invalid_argument);
+}
+
+// Проверяет запись трассы аллокаций очереди и её чтение из бинарного потока.
+TEST(AllocationTraceTest, RecordsQueueAllocationsRoundTrip) {
+    std::stringstream trace;
+    CustomBlockMemoryResource arena(1 << 16);
+    {
+        RecordingMemoryResource recorder(&arena, trace, 48);
+        PmrQueue<int> queue(&recorder);
+        queue.set_node_cache_limit(0);
+        for (int value = 0; value < 3; ++value) {
+            queue.push(value);
+        }
+        queue.pop();
+        EXPECT_EQ(recorder.recorded_events(), 4u);
+    }
+    EXPECT_EQ(arena.used_bytes(), 0u);
+
+    const std::vector<AllocationTraceRecord> records = read_allocation_trace(trace);
+    ASSERT_EQ(records.size(), 6u);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(records[i].kind, AllocationEventKind::allocate);
+        EXPECT_EQ(records[i].allocation_id, i);
+        EXPECT_GE(records[i].size, sizeof(int));
+        EXPECT_EQ(records[i].thread, 0u);
+    }
+    EXPECT_EQ(records[3].kind, AllocationEventKind::deallocate);
+    EXPECT_EQ(records[3].allocation_id, 0u);
+    EXPECT_LE(records[0].timestamp_ns, records[5].timestamp_ns);
+
+    std::stringstream garbage("not a trace");
+    EXPECT_THROW(read_allocation_trace(garbage), std::runtime_error);
+}
+
+// Проверяет воспроизведение трассы на другом ресурсе и подсчёт отказов.
+TEST(AllocationTraceTest, ReplaysTraceAgainstAnyResource) {
+    std::stringstream trace;
+    {
+        RecordingMemoryResource recorder(std::pmr::new_delete_resource(), trace);
+        std::vector<void*> blocks;
+        for (std::size_t size : {64u, 128u, 256u}) {
+            blocks.push_back(recorder.allocate(size, 16));
+        }
+        recorder.deallocate(blocks[1], 128, 16);
+        blocks.push_back(recorder.allocate(512, 64));
+        for (std::size_t i : {0u, 2u, 3u}) {
+            recorder.deallocate(blocks[i], i == 3 ? 512 : (i == 0 ? 64 : 256), i == 3 ? 64 : 16);
+        }
+    }
+    const std::vector<AllocationTraceRecord> records = read_allocation_trace(trace);
+    ASSERT_EQ(records.size(), 8u);
+    EXPECT_EQ(records[4].alignment(), 64u);
+
+    TlsfMemoryResource tlsf(1 << 14);
+    const TraceReplayResult result = replay_allocation_trace(records, tlsf);
+    EXPECT_EQ(result.allocations, 4u);
+    EXPECT_EQ(result.deallocations, 4u);
+    EXPECT_EQ(result.failures, 0u);
+    EXPECT_EQ(result.peak_live_bytes, 64u + 256u + 512u);
+    EXPECT_GE(result.peak_footprint_bytes, result.peak_live_bytes);
+    EXPECT_GE(result.fragmentation, 0.0);
+    EXPECT_LE(result.latency_p50_ns, result.latency_max_ns);
+    EXPECT_EQ(tlsf.largest_free_gap(), tlsf.capacity() - tlsf.used_bytes());
+
+    CustomBlockMemoryResource tiny(600);
+    const TraceReplayResult constrained = replay_allocation_trace(records, tiny);
+    EXPECT_GT(constrained.failures, 0u);
+    EXPECT_EQ(tiny.used_bytes(), 0u);
+}
+
+// Проверяет границы корзин лог-линейной гистограммы и вычисление квантилей.
+TEST(QueueTelemetryTest, HistogramBucketsAndQuantiles) {
+    for (std::uint64_t value : {0ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        const std::size_t bucket = LogLinearHistogram::bucket_of(value);
+        ASSERT_LT(bucket, LogLinearHistogram::kBucketCount);
+        EXPECT_GE(LogLinearHistogram::bucket_upper_bound(bucket), value);
+        if (bucket > 0) {
+            EXPECT_LT(LogLinearHistogram::bucket_upper_bound(bucket - 1), value);
+        }
+    }
+
+    LogLinearHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    const HistogramSnapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.max, 1000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 500.5);
+    EXPECT_NEAR(static_cast<double>(snapshot.value_at(0.5)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(snapshot.value_at(0.99)), 990.0, 990.0 / 16);
+    EXPECT_EQ(snapshot.value_at(1.0), 1000u);
+}
+
+// Проверяет время пребывания, глубину и счётчики очереди с телеметрией и отсутствие накладных расходов без неё.
+TEST(QueueTelemetryTest, RecordsSojournTimeAndDepth) {
+    PmrQueue<int, QueueTelemetry> queue;
+    for (int value = 0; value < 5; ++value) {
+        queue.push(value);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    queue.pop();
+    queue.pop();
+
+    PmrQueue<int, QueueTelemetry> other;
+    other.push(10);
+    queue.splice(other);
+
+    const QueueTelemetrySnapshot snapshot = queue.telemetry().snapshot();
+    EXPECT_EQ(snapshot.pushes, 6u);
+    EXPECT_EQ(snapshot.pops, 2u);
+    EXPECT_EQ(snapshot.depth, 4u);
+    EXPECT_EQ(snapshot.max_depth, 5u);
+    EXPECT_EQ(snapshot.sojourn_ns.count, 2u);
+    EXPECT_GE(snapshot.sojourn_ns.value_at(0.0), 1'000'000u);
+    EXPECT_EQ(snapshot.depth_samples.count, 8u);
+    EXPECT_GT(snapshot.push_rate, 0.0);
+    EXPECT_EQ(other.telemetry().snapshot().pops, 1u);
+
+    queue.telemetry().reset();
+    EXPECT_EQ(queue.telemetry().snapshot().pushes, 0u);
+    EXPECT_EQ(queue.telemetry().snapshot().max_depth, 4u);
+
+    CustomBlockMemoryResource resource(1024);
+    PmrQueue<int> plain(&resource);
+    plain.push(1);
+    EXPECT_EQ(resource.used_bytes(), sizeof(void*) * 2);
+    EXPECT_TRUE(std::is_empty_v<NoQueueTelemetry>);
+}
+
+// Проверяет, что компактная очередь связывает узлы 32-битными смещениями и тратит вдвое меньше памяти на int.
+TEST(CompactPmrQueueTest, UsesHalfTheBytesPerIntNode) {
+    CustomBlockMemoryResource compact_resource(4096);
+    CustomBlockMemoryResource plain_resource(4096);
+    CompactPmrQueue<int> compact(compact_resource);
+    PmrQueue<int> plain(&plain_resource);
+    for (int value = 0; value < 10; ++value) {
+        compact.push(value);
+        plain.push(value);
+    }
+    EXPECT_EQ(CompactPmrQueue<int>::node_size(), 8u);
+    EXPECT_EQ(compact_resource.used_bytes(), 80u);
+    EXPECT_EQ(plain_resource.used_bytes(), 160u);
+
+    std::vector<int> collected(compact.begin(), compact.end());
+    EXPECT_EQ(collected.size(), 10u);
+    EXPECT_EQ(collected.front(), 0);
+    EXPECT_EQ(collected.back(), 9);
+    compact.pop();
+    EXPECT_EQ(compact.front(), 1);
+    EXPECT_EQ(compact.size(), 9u);
+
+    CompactPmrQueue<int> moved(std::move(compact));
+    EXPECT_TRUE(compact.empty());
+    EXPECT_EQ(moved.front(), 1);
+    moved.clear();
+    EXPECT_EQ(compact_resource.used_bytes(), 0u);
+    EXPECT_THROW(moved.pop(), std::out_of_range);
+}
+
+// Проверяет построение pmr-строк из того же ресурса и работу поверх статического и TLSF-ресурсов.
+TEST(CompactPmrQueueTest, PropagatesResourceToElements) {
+    StaticBlockMemoryResource<2048> static_resource;
+    CompactPmrQueue<std::pmr::string> strings(static_resource);
+    strings.emplace("a string long enough to need its own heap block");
+    EXPECT_EQ(strings.front().get_allocator().resource(), &static_resource);
+    EXPECT_GE(static_resource.block_count(), 2u);
+    strings.pop();
+    EXPECT_EQ(static_resource.block_count(), 0u);
+
+    TlsfMemoryResource tlsf(1 << 12);
+    CompactPmrQueue<std::uint64_t> numbers(tlsf);
+    for (std::uint64_t value = 0; value < 20; ++value) {
+        numbers.push(value * value);
+    }
+    std::uint64_t sum = 0;
+    while (!numbers.empty()) {
+        sum += numbers.front();
+        numbers.pop();
+    }
+    EXPECT_EQ(sum, 2470u);
+}
+
+// Проверяет неисключительные операции очереди на пустой очереди и при исчерпании ресурса.
+TEST(PmrQueueTryTest, TryOperationsReportFailureWithoutThrowing) {
+    CustomBlockMemoryResource resource(64);
+    PmrQueue<std::uint64_t> queue(&resource);
+    std::uint64_t out = 0;
+    EXPECT_FALSE(queue.try_pop(out));
+    EXPECT_EQ(queue.try_front(), nullptr);
+
+    std::size_t pushed = 0;
+    while (queue.try_emplace(pushed)) {
+        ++pushed;
+    }
+    EXPECT_EQ(pushed, 4u);
+    EXPECT_EQ(queue.size(), 4u);
+    ASSERT_NE(queue.try_front(), nullptr);
+    EXPECT_EQ(*queue.try_front(), 0u);
+
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out, 0u);
+    EXPECT_TRUE(queue.try_emplace(std::uint64_t{99}));
+    EXPECT_FALSE(queue.try_emplace(std::uint64_t{100}));
+
+    queue.set_node_cache_limit(1);
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(queue.cached_nodes(), 1u);
+    EXPECT_TRUE(queue.try_emplace(std::uint64_t{101}));
+    EXPECT_EQ(queue.cached_nodes(), 0u);
+}
+
+// Проверяет, что try_allocate возвращает nullptr, а allocate по-прежнему бросает std::bad_alloc.
+TEST(PmrQueueTryTest, ResourceTryAllocateReturnsNull) {
+    CustomBlockMemoryResource resource(128, 16);
+    void* first = resource.try_allocate(100);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(resource.try_allocate(64), nullptr);
+    EXPECT_EQ(resource.try_allocate(8, 64), nullptr);
+    EXPECT_THROW(static_cast<void>(resource.allocate(64)), std::bad_alloc);
+    resource.deallocate(first, 100);
+    EXPECT_NE(resource.try_allocate(128), nullptr);
+
+    std::pmr::memory_resource* generic = &resource;
+    PmrQueue<int> fallback(generic);
+    EXPECT_FALSE(fallback.try_emplace(1));
+}
+
+namespace {
+
+struct SharedRecord {
+    std::uint32_t id;
+    double value;
+};
+
+}  // namespace
+
+// Проверяет обмен записями через именованный сегмент, отображённый по двум разным адресам.
+TEST(SharedMemoryQueueTest, ExchangesRecordsAcrossMappings) {
+    const std::string name = "/pmr_queue_test_" + std::to_string(::getpid());
+    const std::size_t bytes = SharedMemoryQueue<SharedRecord>::region_bytes_for(256);
+    SharedMemorySegment producer_segment(name, SharedSegmentMode::create, bytes);
+    SharedMemorySegment consumer_segment(name, SharedSegmentMode::attach);
+    ASSERT_NE(producer_segment.data(), consumer_segment.data());
+    EXPECT_EQ(consumer_segment.size(), bytes);
+
+    SharedMemoryQueue<SharedRecord> producer(producer_segment.data(), bytes, SharedSegmentMode::create);
+    SharedMemoryQueue<SharedRecord> consumer(consumer_segment.data(), consumer_segment.size(), SharedSegmentMode::attach);
+    std::uint32_t pushed = 0;
+    while (producer.try_push({pushed, pushed * 0.5})) {
+        ++pushed;
+    }
+    EXPECT_GE(pushed, 256u);
+    EXPECT_EQ(consumer.size(), pushed);
+
+    SharedRecord record{};
+    ASSERT_TRUE(consumer.try_pop(record));
+    EXPECT_EQ(record.id, 0u);
+    std::uint32_t expected = 1;
+    consumer.drain([&](const SharedRecord& next) { EXPECT_EQ(next.id, expected++); });
+    EXPECT_EQ(expected, pushed);
+    EXPECT_TRUE(producer.empty());
+    EXPECT_EQ(producer.resource().used_bytes(), 0u);
+    EXPECT_EQ(producer.pops(), pushed);
+
+    std::vector<std::byte> garbage(bytes + 64);
+    void* aligned = garbage.data() + (64 - reinterpret_cast<std::uintptr_t>(garbage.data()) % 64) % 64;
+    EXPECT_THROW(SharedMemoryQueue<SharedRecord>(aligned, bytes, SharedSegmentMode::attach), std::invalid_argument);
+}
+
+// Проверяет восстановление очереди после гибели процесса-потребителя, удерживавшего блокировку.
+TEST(SharedMemoryQueueTest, RecoversAfterConsumerCrash) {
+    const std::size_t bytes = SharedMemoryQueue<std::uint64_t>::region_bytes_for(64);
+    void* region = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(region, MAP_FAILED);
+    {
+        SharedMemoryQueue<std::uint64_t> queue(region, bytes, SharedSegmentMode::create);
+        for (std::uint64_t value = 0; value < 10; ++value) {
+            queue.push(value);
+        }
+
+        const pid_t child = ::fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            SharedMemoryQueue<std::uint64_t> peer(region, bytes, SharedSegmentMode::attach);
+            peer.drain([](std::uint64_t value) {
+                if (value == 2) {
+                    ::_exit(0);
+                }
+            });
+            ::_exit(1);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(child, &status, 0), child);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+
+        EXPECT_EQ(queue.recoveries(), 1u);
+        EXPECT_EQ(queue.size(), 8u);
+        EXPECT_EQ(queue.pops(), 2u);
+        EXPECT_EQ(queue.resource().block_count(), 8u);
+
+        std::uint64_t value = 0;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, 2u);
+        EXPECT_TRUE(queue.try_push(10));
+        EXPECT_EQ(queue.drain([](std::uint64_t) {}), 8u);
+        EXPECT_EQ(queue.resource().used_bytes(), 0u);
+    }
+    ::munmap(region, bytes);
+}
+
+// Проверяет, что восстановление обрывает зацикленную цепочку, оставленную погибшим процессом
+TEST(SharedMemoryQueueTest, CutsLoopedChainOnRecovery) {
+    const std::size_t bytes = SharedMemoryQueue<std::uint64_t>::region_bytes_for(64);
+    void* region = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(region, MAP_FAILED);
+    {
+        SharedMemoryQueue<std::uint64_t> queue(region, bytes, SharedSegmentMode::create);
+        for (std::uint64_t value = 0; value < 10; ++value) {
+            queue.push(value);
+        }
+
+        const pid_t child = ::fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            SharedMemoryQueue<std::uint64_t> peer(region, bytes, SharedSegmentMode::attach);
+            std::uint64_t third = 0;
+            peer.drain([&third](const std::uint64_t& value) {
+                // The link follows the value inside the node; point node 3 back at itself.
+                auto* next = const_cast<std::uint64_t*>(&value + 1);
+                if (value == 2) {
+                    third = *next;
+                } else if (value == 3) {
+                    *next = third;
+                    ::_exit(0);
+                }
+            });
+            ::_exit(1);
+        }
+        int status = 0;
+        ASSERT_EQ(::waitpid(child, &status, 0), child);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+
+        EXPECT_EQ(queue.recoveries(), 1u);
+        EXPECT_EQ(queue.size(), 1u);
+        EXPECT_EQ(queue.resource().block_count(), 1u);
+        std::uint64_t value = 0;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, 3u);
+        EXPECT_FALSE(queue.try_pop(value));
+        EXPECT_EQ(queue.resource().used_bytes(), 0u);
+    }
+    ::munmap(region, bytes);
+}
+
+// Проверяет, что сериализатор восстанавливает pmr-строки и числа в ресурсе назначения
+TEST(SpillingPmrQueueTest, SerializerRoundTrip) {
+    CustomBlockMemoryResource resource(1024);
+    std::vector<std::byte> bytes;
+    QueueSerializer<std::pmr::string>::write(std::pmr::string("spilled string"), bytes);
+    QueueSerializer<int>::write(42, bytes);
+
+    std::span<const std::byte> in(bytes);
+    const std::pmr::polymorphic_allocator<> alloc(&resource);
+    const std::pmr::string text = QueueSerializer<std::pmr::string>::read(in, alloc);
+    EXPECT_EQ(text, "spilled string");
+    EXPECT_EQ(text.get_allocator().resource(), &resource);
+    EXPECT_EQ(QueueSerializer<int>::read(in, alloc), 42);
+    EXPECT_TRUE(in.empty());
+    EXPECT_THROW(QueueSerializer<int>::read(in, alloc), std::runtime_error);
+}
+
+// Проверяет, что очереди в общем каталоге выгружают средние сегменты на диск и сохраняют порядок FIFO
+TEST(SpillingPmrQueueTest, SpillsMiddleSegmentsAndKeepsOrder) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("pmr_spill_" + std::to_string(::getpid()));
+    CustomBlockMemoryResource resource(4096);
+    CustomBlockMemoryResource other_resource(4096);
+    {
+        SpillingPmrQueue<std::uint64_t> queue(resource, SpillOptions{directory, 8, 0.5, 1});
+        SpillingPmrQueue<std::uint64_t> other(other_resource, SpillOptions{directory, 8, 0.5, 1});
+        for (std::uint64_t value = 0; value < 400; ++value) {
+            queue.push(value);
+            other.push(value + 1000);
+        }
+        EXPECT_EQ(queue.size(), 400u);
+        EXPECT_GT(queue.spilled_segments(), 0u);
+        EXPECT_GT(other.spilled_segments(), 0u);
+        EXPECT_LE(resource.used_bytes(), resource.capacity());
+        EXPECT_FALSE(std::filesystem::is_empty(directory));
+
+        for (std::uint64_t expected = 0; expected < 400; ++expected) {
+            ASSERT_EQ(queue.front(), expected);
+            queue.pop();
+            ASSERT_EQ(other.front(), expected + 1000);
+            other.pop();
+        }
+        EXPECT_TRUE(queue.empty());
+        EXPECT_EQ(queue.stats().segments_loaded, queue.stats().segments_spilled);
+        EXPECT_EQ(queue.stats().bytes_read, queue.stats().bytes_written);
+        EXPECT_TRUE(std::filesystem::is_empty(directory));
+        EXPECT_THROW(queue.pop(), std::out_of_range);
+    }
+    std::filesystem::remove_all(directory);
+    EXPECT_THROW((SpillingPmrQueue<std::uint64_t>(resource, SpillOptions{})), std::invalid_argument);
+}
+
+// Проверяет, что при нехватке памяти для загрузки головы очередь выгружает хвост, а при неудаче остаётся целой
+TEST(SpillingPmrQueueTest, SurvivesHeadLoadWithoutRoom) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("pmr_spill_load_" + std::to_string(::getpid()));
+    CustomBlockMemoryResource resource(4096);
+    std::vector<void*> blockers;
+    const auto exhaust = [&resource, &blockers] {
+        try {
+            while (true) {
+                blockers.push_back(resource.allocate(8, 8));
+            }
+        } catch (const std::bad_alloc&) {
+        }
+    };
+    {
+        // A tiny watermark keeps every middle segment on disk.
+        SpillingPmrQueue<std::uint64_t> queue(resource, SpillOptions{directory, 8, 0.01, 0});
+        for (std::uint64_t value = 0; value < 40; ++value) {
+            queue.push(value);
+        }
+        for (std::uint64_t expected = 0; expected < 8; ++expected) {
+            ASSERT_EQ(queue.front(), expected);
+            queue.pop();
+        }
+
+        // The head is reloaded by spilling the resident tail.
+        exhaust();
+        EXPECT_EQ(queue.front(), 8u);
+        EXPECT_EQ(queue.spilled_segments(), 3u);
+        for (std::uint64_t expected = 8; expected < 16; ++expected) {
+            ASSERT_EQ(queue.front(), expected);
+            queue.pop();
+        }
+
+        // Nothing is left to spill, so the load fails without losing the segment.
+        exhaust();
+        EXPECT_THROW(static_cast<void>(queue.front()), std::bad_alloc);
+        EXPECT_THROW(queue.pop(), std::bad_alloc);
+        EXPECT_EQ(queue.size(), 24u);
+        EXPECT_EQ(queue.spilled_segments(), 3u);
+
+        for (void* blocker : blockers) {
+            resource.deallocate(blocker, 8, 8);
+        }
+        for (std::uint64_t expected = 16; expected < 40; ++expected) {
+            ASSERT_EQ(queue.front(), expected);
+            queue.pop();
+        }
+        EXPECT_TRUE(queue.empty());
+        EXPECT_TRUE(std::filesystem::is_empty(directory));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Проверяет, что после перезапуска очередь восстанавливается из журнала с последней контрольной точки
+TEST(DurablePmrQueueTest, ReplaysLogFromCheckpoint) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("pmr_wal_replay_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    const DurableQueueOptions options{directory, 1 << 20, 0, true};
+    {
+        CustomBlockMemoryResource resource(4096);
+        DurablePmrQueue<std::pmr::string> queue(&resource, options);
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_EQ(queue.push(std::pmr::string("record " + std::to_string(i))), static_cast<std::uint64_t>(i + 1));
+        }
+        std::pmr::string value;
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(queue.try_pop(value));
+        }
+        queue.checkpoint();
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, "record 3");
+    }
+    // A torn record at the end of the log is discarded on replay.
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".log") {
+            std::ofstream(entry.path(), std::ios::binary | std::ios::app) << "torn";
+        }
+    }
+    {
+        CustomBlockMemoryResource resource(4096);
+        DurablePmrQueue<std::pmr::string> queue(&resource, options);
+        EXPECT_EQ(queue.size(), 7u);
+        EXPECT_EQ(queue.stats().replayed, 7u);
+        EXPECT_EQ(queue.consumed_sequence(), 3u);
+        EXPECT_GT(resource.used_bytes(), 0u);
+        EXPECT_EQ(queue.push(std::pmr::string("after restart")), 11u);
+
+        std::pmr::string value;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, "record 3");
+        for (int i = 0; i < 7; ++i) {
+            ASSERT_TRUE(queue.try_pop(value));
+        }
+        EXPECT_EQ(value, "after restart");
+        EXPECT_FALSE(queue.try_pop(value));
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Проверяет, что конкурентные производители разделяют fsync и журнал усекается после чтения
+TEST(DurablePmrQueueTest, GroupCommitAndSegmentTruncation) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("pmr_wal_group_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    {
+        DurablePmrQueue<std::uint64_t> queue(std::pmr::new_delete_resource(), DurableQueueOptions{directory, 512, 64, true});
+        constexpr std::uint64_t kProducers = 4;
+        constexpr std::uint64_t kPerProducer = 200;
+        std::vector<std::thread> producers;
+        for (std::uint64_t producer = 0; producer < kProducers; ++producer) {
+            producers.emplace_back([&queue, producer] {
+                for (std::uint64_t i = 0; i < kPerProducer; ++i) {
+                    queue.push(producer * kPerProducer + i);
+                }
+            });
+        }
+        for (auto& thread : producers) {
+            thread.join();
+        }
+        std::vector<std::uint64_t> batch{1000, 1001, 1002};
+        EXPECT_EQ(queue.push_bulk(batch.begin(), batch.end()), kProducers * kPerProducer + batch.size());
+
+        const DurableQueueStats stats = queue.stats();
+        EXPECT_EQ(stats.appends, kProducers * kPerProducer + batch.size());
+        EXPECT_LE(stats.group_commits, stats.appends - batch.size() + 1);
+        EXPECT_GT(queue.segment_count(), 1u);
+
+        std::vector<bool> seen(kProducers * kPerProducer);
+        std::uint64_t value = 0;
+        while (queue.try_pop(value)) {
+            if (value < seen.size()) {
+                EXPECT_FALSE(seen[value]);
+                seen[value] = true;
+            }
+        }
+        EXPECT_EQ(std::count(seen.begin(), seen.end(), true), static_cast<std::ptrdiff_t>(seen.size()));
+        EXPECT_EQ(value, 1002u);
+        queue.checkpoint();
+        EXPECT_EQ(queue.segment_count(), 1u);
+        EXPECT_GT(queue.stats().segments_removed, 0u);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Проверяет, что сбой автоматического чекпоинта не теряет извлечённый элемент, а неудачный push_bulk не оставляет записей
+TEST(DurablePmrQueueTest, KeepsPoppedElementWhenCheckpointFails) {
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("pmr_wal_failure_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    {
+        CustomBlockMemoryResource resource(256);
+        DurablePmrQueue<std::pmr::string> queue(&resource, DurableQueueOptions{directory, 1 << 20, 1, false});
+        const std::vector<std::pmr::string> oversized(2, std::pmr::string(1024, 'x'));
+        EXPECT_THROW(queue.push_bulk(oversized.begin(), oversized.end()), std::bad_alloc);
+        EXPECT_EQ(queue.durable_sequence(), 0u);
+        EXPECT_EQ(queue.stats().appends, 0u);
+
+        EXPECT_EQ(queue.push(std::pmr::string("first")), 1u);
+        EXPECT_EQ(queue.push(std::pmr::string("second")), 2u);
+        // A directory in place of the temporary checkpoint file makes every checkpoint throw.
+        std::filesystem::create_directory(directory / "checkpoint.tmp");
+        std::pmr::string value;
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, "first");
+        EXPECT_EQ(queue.stats().checkpoint_failures, 1u);
+        EXPECT_THROW(queue.checkpoint(), std::system_error);
+
+        std::filesystem::remove(directory / "checkpoint.tmp");
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, "second");
+        EXPECT_EQ(queue.stats().checkpoint_failures, 1u);
+        EXPECT_EQ(queue.stats().checkpoints, 1u);
+    }
+    {
+        DurablePmrQueue<std::pmr::string> queue(std::pmr::new_delete_resource(), DurableQueueOptions{directory});
+        EXPECT_TRUE(queue.empty());
+        EXPECT_EQ(queue.consumed_sequence(), 2u);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Проверяет, что снимок PmrQueue восстанавливается в ресурс по другому адресу вместе с кэшем и резервом
+TEST(QueueSnapshotTest, RestoresPmrQueueWithPointerFixups) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / ("pmr_snapshot_" + std::to_string(::getpid()) + ".bin");
+    CustomBlockMemoryResource source(8192);
+    {
+        PmrQueue<std::uint64_t> queue(&source);
+        queue.set_node_cache_limit(4);
+        for (std::uint64_t value = 0; value < 40; ++value) {
+            queue.push(value);
+        }
+        queue.pop();
+        queue.pop();
+        queue.reserve(48);
+        snapshot_queue(path, source, queue);
+    }
+
+    CustomBlockMemoryResource target(8192);
+    PmrQueue<std::uint64_t> restored(&target);
+    restore_queue(path, target, restored);
+    EXPECT_EQ(restored.size(), 38u);
+    EXPECT_EQ(restored.cached_nodes(), 2u);
+    EXPECT_EQ(restored.capacity(), 48u);
+    EXPECT_EQ(restored.node_cache_limit(), 4u);
+    EXPECT_GT(target.used_bytes(), 0u);
+    EXPECT_THROW(restore_queue(path, target, restored), std::invalid_argument);
+
+    std::uint64_t expected = 2;
+    for (const std::uint64_t value : restored) {
+        EXPECT_EQ(value, expected++);
+    }
+    restored.push(100);
+    while (restored.size() > 1) {
+        restored.pop();
+    }
+    EXPECT_EQ(restored.front(), 100u);
+    restored.pop();
+    restored.shrink_to_fit();
+    EXPECT_EQ(target.used_bytes(), 0u);
+    std::filesystem::remove(path);
+}
+
+// Проверяет, что CompactPmrQueue восстанавливается из снимка без исправления ссылок
+TEST(QueueSnapshotTest, RestoresCompactQueueFromOffsets) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / ("pmr_compact_snapshot_" + std::to_string(::getpid()) + ".bin");
+    CustomBlockMemoryResource source(4096);
+    {
+        CompactPmrQueue<int> queue(source);
+        for (int value = 0; value < 100; ++value) {
+            queue.push(value);
+        }
+        snapshot_queue(path, source, queue);
+        CompactPmrQueue<int> other(source);
+        EXPECT_THROW(restore_queue(path, source, other), std::logic_error);
+    }
+
+    CustomBlockMemoryResource target(4096);
+    PmrQueue<int> wrong_kind(&target);
+    EXPECT_THROW(restore_queue(path, target, wrong_kind), std::runtime_error);
+    CompactPmrQueue<int> restored(target);
+    restore_queue(path, target, restored);
+    ASSERT_EQ(restored.size(), 100u);
+    for (int expected = 0; expected < 100; ++expected) {
+        ASSERT_EQ(restored.front(), expected);
+        restored.pop();
+    }
+    EXPECT_EQ(target.used_bytes(), 0u);
+    std::filesystem::remove(path);
+}
+
+// Проверяет, что серия вставок в пустую очередь сигнализирует eventfd только один раз
+TEST(NotifyingPmrQueueTest, CoalescesNotificationsPerTransition) {
+    CustomBlockMemoryResource resource(2048);
+    NotifyingPmrQueue<int> queue(&resource);
+    const auto readable = [&queue] {
+        pollfd descriptor{queue.fd(), POLLIN, 0};
+        return ::poll(&descriptor, 1, 0) == 1;
+    };
+    EXPECT_FALSE(readable());
+
+    for (int value = 0; value < 5; ++value) {
+        queue.push(value);
+    }
+    EXPECT_EQ(queue.notifications(), 1u);
+    EXPECT_TRUE(readable());
+
+    std::vector<int> received;
+    EXPECT_EQ(queue.drain([&received](int value) { received.push_back(value); }), 5u);
+    EXPECT_EQ(received, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_FALSE(readable());
+    EXPECT_EQ(resource.used_bytes(), 0u);
+
+    queue.push(5);
+    EXPECT_EQ(queue.notifications(), 2u);
+    EXPECT_TRUE(readable());
+    int value = 0;
+    EXPECT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 5);
+    EXPECT_TRUE(queue.acknowledge());
+    EXPECT_FALSE(queue.acknowledge());
+
+    // A throwing consumer keeps the rest of the batch queued and signaled.
+    for (int pushed = 6; pushed < 10; ++pushed) {
+        queue.push(pushed);
+    }
+    received.clear();
+    const auto failing = [&received](int item) {
+        received.push_back(item);
+        if (item == 7) {
+            throw std::runtime_error("consumer failed");
+        }
+    };
+    EXPECT_THROW(queue.drain(failing), std::runtime_error);
+    EXPECT_EQ(received, (std::vector<int>{6, 7}));
+    EXPECT_TRUE(readable());
+    received.clear();
+    EXPECT_EQ(queue.drain([&received](int item) { received.push_back(item); }), 2u);
+    EXPECT_EQ(received, (std::vector<int>{8, 9}));
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет, что цикл epoll получает все элементы от производителя без потерянных пробуждений
+TEST(NotifyingPmrQueueTest, EpollLoopReceivesEveryElement) {
+    NotifyingPmrQueue<int> queue;
+    const int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    ASSERT_GE(epoll_fd, 0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    ASSERT_EQ(::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, queue.fd(), &event), 0);
+
+    constexpr int kElements = 5000;
+    std::thread producer([&queue] {
+        for (int value = 0; value < kElements; ++value) {
+            queue.push(value);
+            if (value % 100 == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < kElements) {
+        epoll_event ready{};
+        ASSERT_EQ(::epoll_wait(epoll_fd, &ready, 1, 5000), 1);
+        queue.drain([&expected](int value) { EXPECT_EQ(value, expected++); });
+    }
+    producer.join();
+    EXPECT_LE(queue.notifications(), static_cast<std::uint64_t>(kElements));
+    EXPECT_TRUE(queue.empty());
+    ::close(epoll_fd);
+}
+
+// Проверяет, что при отложенном освобождении pop не вызывает деструкторы до точки покоя
+TEST(NodeReclaimerTest, DefersDestructionUntilQuiesce) {
+    struct Tracked {
+        explicit Tracked(int* counter) : destroyed(counter) {}
+        ~Tracked() { ++*destroyed; }
+        int* destroyed;
+    };
+
+    int destroyed = 0;
+    CustomBlockMemoryResource resource(4096);
+    NodeReclaimer reclaimer;
+    {
+        PmrQueue<Tracked> queue(&resource);
+        queue.set_reclaimer(&reclaimer, 4);
+        for (int i = 0; i < 12; ++i) {
+            queue.emplace(&destroyed);
+        }
+        const std::size_t used = resource.used_bytes();
+        for (int i = 0; i < 10; ++i) {
+            queue.pop();
+        }
+        EXPECT_EQ(destroyed, 0);
+        EXPECT_EQ(resource.used_bytes(), used);
+        EXPECT_EQ(queue.retired_nodes(), 2u);
+        EXPECT_EQ(reclaimer.pending(), 8u);
+        EXPECT_THROW(static_cast<void>(queue.image(resource.data())), std::logic_error);
+
+        queue.flush_retired();
+        EXPECT_EQ(reclaimer.quiesce(), 10u);
+        EXPECT_EQ(destroyed, 10);
+        EXPECT_EQ(resource.used_bytes(), used - 10 * (used / 12));
+        EXPECT_EQ(queue.image(resource.data()).size, 2u);
+    }
+    // The queue's destructor hands its remaining elements to the reclaimer as well.
+    EXPECT_EQ(destroyed, 10);
+    EXPECT_EQ(reclaimer.quiesce(), 2u);
+    EXPECT_EQ(destroyed, 12);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+    EXPECT_EQ(reclaimer.reclaimed(), 12u);
+}
+
+// Проверяет, что фоновый освободитель корректно возвращает память через синхронизированный ресурс
+TEST(NodeReclaimerTest, BackgroundReclaimKeepsAccountingExact) {
+    CustomBlockMemoryResource block_resource(1 << 16);
+    SynchronizedMemoryResource resource(&block_resource);
+    NodeReclaimer reclaimer(ReclaimMode::background);
+    EXPECT_TRUE(reclaimer.background());
+    {
+        PmrQueue<std::pmr::string> queue(&resource);
+        queue.set_reclaimer(&reclaimer, 16);
+        for (int round = 0; round < 200; ++round) {
+            for (int i = 0; i < 20; ++i) {
+                queue.emplace("a string long enough to need its own allocation " + std::to_string(i));
+            }
+            for (int i = 0; i < 20; ++i) {
+                const std::string expected = "a string long enough to need its own allocation " + std::to_string(i);
+                ASSERT_EQ(std::string_view(queue.front()), expected);
+                queue.pop();
+            }
+        }
+        queue.flush_retired();
+    }
+    reclaimer.quiesce();
+    while (reclaimer.pending() != 0) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(reclaimer.reclaimed(), 4000u);
+    EXPECT_EQ(block_resource.used_bytes(), 0u);
+}
+
+// Проверяет, что элементы публикуются целыми пакетами, а неполный пакет уходит по сбросу или таймауту
+TEST(BatchExchangeQueueTest, PublishesWholeBatches) {
+    BatchExchangeQueue<int> exchange(std::pmr::new_delete_resource(), 4, std::chrono::milliseconds(20));
+    PmrQueue<int> received(std::pmr::new_delete_resource());
+    for (int value = 0; value < 6; ++value) {
+        exchange.push(value);
+    }
+    EXPECT_EQ(exchange.take(received), 4u);
+    EXPECT_EQ(exchange.take(received), 0u);
+    EXPECT_FALSE(exchange.flush_if_due());
+
+    // The consumer pulls an overdue partial batch without the producer's help.
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(exchange.take(received), 2u);
+    EXPECT_FALSE(exchange.flush_if_due());
+    exchange.push(6);
+    const auto started = std::chrono::steady_clock::now();
+    EXPECT_EQ(exchange.take_for(received, std::chrono::seconds(5)), 1u);
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(1));
+    exchange.push(7);
+    exchange.flush();
+    EXPECT_EQ(exchange.take(received), 1u);
+    EXPECT_EQ(exchange.batches_published(), 4u);
+
+    int expected = 0;
+    for (const int value : received) {
+        EXPECT_EQ(value, expected++);
+    }
+    EXPECT_EQ(expected, 8);
+}
+
+// Проверяет передачу пакетов между потоками и завершение потребителя после close
+TEST(BatchExchangeQueueTest, HandsOffBetweenThreads) {
+    SynchronizedMemoryResource resource(std::pmr::new_delete_resource());
+    BatchExchangeQueue<std::uint64_t> exchange(&resource, 64);
+    constexpr std::uint64_t kElements = 100000;
+    std::thread producer([&exchange] {
+        for (std::uint64_t value = 0; value < kElements; ++value) {
+            exchange.push(value);
+        }
+        exchange.close();
+    });
+
+    PmrQueue<std::uint64_t> batch(&resource);
+    std::uint64_t expected = 0;
+    while (!exchange.closed()) {
+        exchange.take_for(batch, std::chrono::milliseconds(100));
+        while (!batch.empty()) {
+            ASSERT_EQ(batch.front(), expected++);
+            batch.pop();
+        }
+    }
+    producer.join();
+    EXPECT_EQ(expected, kElements);
+    EXPECT_GE(exchange.batches_published(), kElements / 64);
+}
@@ -0,0 +1,48 @@
+// Built with -fno-exceptions: the queue and resource headers must compile without try/throw,
+// and the try_* API is the only way to observe failures.
+#include "memory_resource.hpp"
+#include "pmr_queue.hpp"
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+static_assert(!PMR_QUEUE_HAS_EXCEPTIONS, "This test must be compiled with exceptions disabled");
+
+// Проверяет цикл try_emplace/try_pop до исчерпания буфера без исключений.
+TEST(NoExceptionsTest, QueueTryOperationsOnExhaustedBuffer) {
+    CustomBlockMemoryResource resource(256);
+    PmrQueue<std::uint64_t> queue(&resource);
+
+    std::uint64_t pushed = 0;
+    while (queue.try_emplace(pushed)) {
+        ++pushed;
+    }
+    EXPECT_EQ(pushed, 16u);
+    EXPECT_EQ(resource.try_allocate(1), nullptr);
+
+    std::uint64_t sum = 0;
+    std::uint64_t value = 0;
+    while (queue.try_pop(value)) {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 120u);
+    EXPECT_EQ(queue.try_front(), nullptr);
+    EXPECT_EQ(resource.used_bytes(), 0u);
+}
+
+// Проверяет pmr-строки в очереди и аварийное завершение pop() на пустой очереди.
+TEST(NoExceptionsTest, StringsAndAbortOnEmptyPop) {
+    CustomBlockMemoryResource resource(4096);
+    PmrQueue<std::pmr::string> queue(&resource);
+    ASSERT_TRUE(queue.try_emplace("a string long enough to need its own heap block"));
+    ASSERT_NE(queue.try_front(), nullptr);
+    EXPECT_EQ(queue.try_front()->get_allocator().resource(), &resource);
+
+    std::pmr::string out(&resource);
+    EXPECT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(out.size(), 47u);
+    EXPECT_DEATH(queue.pop(), "");
+}